@@ -25,6 +25,32 @@
 elements trace[MAX_TRACE_SIZE];
 elements* traceptr = trace;
 
+/* Description: These globals hold the trace entries marked dirty by
+ * setVariable() which are waiting to be recomputed by reevaluate().
+ * */
+elements* dirtyTrace[MAX_TRACE_SIZE];
+int dirtyCount = 0;
+
+/* Description: These globals hold the lanes of the batch replay. Row i of
+ * batchVal and batchBar holds the value and adjoint of trace[i] at each
+ * of the batchLanes operating points. batchTemp holds two rows of scratch
+ * space for the reverse sweep.
+ * */
+double* batchVal = NULL;
+double* batchBar = NULL;
+double* batchTemp = NULL;
+int batchLanes = 0;
+int batchCapacity = 0;
+
+/* Description: These globals hold the statistics reported by getStats()
+ * and the names printStats() gives the opcodes. The phases are only timed
+ * while statsTiming is set, by setStatsTiming().
+ * */
+deStats engineStats;
+int statsTiming = 0;
+const char* opcodeNames[funcv + 1] = {"empty", "constant", "variable",
+	"+", "-", "*", "/", "recip", "sin", "cos", "pow", "="};
+
 /*********************************************************************/
 
 /* Description: This function is used to create a new variable table 
@@ -32,10 +58,17 @@ elements* traceptr = trace;
  * table.
  * */
 hshtbl* getNewTable(){
-	return hshinit(varHash, varReHash,
+	hshopts opts;
+
+	/* the names and their maps all go at once, in hshkill, and the
+	 * usual handful of variables is found by a scan of their hashes */
+	opts.mode = hshARENA | hshSMALL;
+	opts.reserve = 0;
+	opts.adupe = varArenaDup;
+	return hshinitopts(varHash, varReHash,
 					  varCmp,
 					  varDup, varFree,
-					  0);
+					  0, &opts);
 }
 
 /* Description: This function is used to read the input equation file,
@@ -57,6 +90,8 @@ Equation* readEquation(char* filename, hshtbl* varTable){
 	varMapP tempVar;
 	Equation* head = NULL;
 	Equation* temp = NULL;
+	phaseClock timer = startPhase();
+	unsigned long probes = hshstatus(varTable).probes;
 	
 	/*Open first file and read the contents*/		
 	if ((fp = fopen(filename,"r")) == NULL){
@@ -73,6 +108,7 @@ Equation* readEquation(char* filename, hshtbl* varTable){
 				fclose(fp);
 				fp=NULL;
 			}
+			stopPhase(timer, &engineStats.parseWall, &engineStats.parseCpu);
 			return NULL;
 		}
 		while(single_line!=NULL){
@@ -89,15 +125,23 @@ Equation* readEquation(char* filename, hshtbl* varTable){
 					head->token = type;
 					head->type = getType(type);
 				}
+				head->var = NULL;
 				if (head->type == indepv){
 					tempVar = (varMapP) malloc(sizeof(varMap));
 					tempVar->key=head->token;
 					tempVar->value=0.0;
+					tempVar->id=-1;
 					var = hshinsert(varTable, tempVar);
 					if (var == NULL){
 						fprintf(stderr,"Memory Error");
 						exit(1);
-					}						
+					}
+					free(tempVar);
+					/* intern the name */
+					if (var->id < 0)
+						var->id = getNumberVariables(varTable) - 1;
+					head->token = var->key;
+					head->var = (struct varMap*) var;						
 				}
 				head->next=NULL;
 			}
@@ -114,15 +158,23 @@ Equation* readEquation(char* filename, hshtbl* varTable){
 					temp->token = type;
 					temp->type = getType(type);
 				}
+				temp->var = NULL;
 				if (temp->type == indepv){
 					tempVar = (varMapP) malloc(sizeof(varMap));
 					tempVar->key=temp->token;
 					tempVar->value=0.0;
+					tempVar->id=-1;
 					var = hshinsert(varTable, tempVar);
 					if (var == NULL){
 						fprintf(stderr,"Memory Error");
 						exit(1);
 					}
+					free(tempVar);
+					/* intern the name */
+					if (var->id < 0)
+						var->id = getNumberVariables(varTable) - 1;
+					temp->token = var->key;
+					temp->var = (struct varMap*) var;
 				}
 				temp->next = (struct Equation*) head;
 				head = temp;
@@ -139,8 +191,11 @@ Equation* readEquation(char* filename, hshtbl* varTable){
 			}
 			else;
 		}
+		engineStats.hashProbes += hshstatus(varTable).probes - probes;
+		stopPhase(timer, &engineStats.parseWall, &engineStats.parseCpu);
 		return head;	
 	}
+	stopPhase(timer, &engineStats.parseWall, &engineStats.parseCpu);
 	return NULL;
 }
 
@@ -210,7 +265,7 @@ void printEquation(Equation* eqn){
 
 /* Description: This function is used by the Hashlib library. It is used 
  * to compare objects of varMap type. Comparison is done by comparing the
- * keys of the 2 items.
+ * keys of the 2 items. Interned keys are equal when their pointers are.
  * Arguments: The two items that are to be compared are passed as lvar and
  * rvar. These are pointers to the object of type varMap.
  * Returns: -1,0,1 is returned depending on
@@ -222,6 +277,8 @@ void printEquation(Equation* eqn){
 int varCmp(void* lvar,void* rvar){
 	varMapP left = (varMapP) lvar;
 	varMapP right = (varMapP) rvar;
+	if (left->key == right->key)
+		return 0;
 	return strcmp(left->key,right->key);
 }
 
@@ -233,9 +290,11 @@ void* varDup(void* var){
 	varMapP myVar = var;
 	varMapP newVar;
 	
-	if((newVar = malloc(sizeof(newVar)))){
+	if((newVar = malloc(sizeof(*newVar)))){
 		if ((newVar->key = strdup(myVar->key))){
 				newVar->value=myVar->value;	
+				newVar->uses=NULL;
+				newVar->id=myVar->id;
 		}
 		else{
 			free(newVar);
@@ -245,6 +304,25 @@ void* varDup(void* var){
 	return newVar;
 }
 
+/* Description: varArenaDup is varDup for a table in the hshARENA mode of
+ * Hashlib. The copy and its key are carved out of the slabs of the table,
+ * which hshkill() releases in one go instead of calling varFree() on each.
+ * */
+void* varArenaDup(void* var, hshtbl* master){
+	varMapP myVar = var;
+	varMapP newVar;
+	size_t length = strlen(myVar->key) + 1;
+
+	if((newVar = hshaalloc(master, sizeof(*newVar) + length))){
+		newVar->key = (char*)(newVar + 1);
+		memcpy(newVar->key, myVar->key, length);
+		newVar->value=myVar->value;
+		newVar->uses=NULL;
+		newVar->id=myVar->id;
+	}
+	return newVar;
+}
+
 /* Description; This function is used by Hashlib Library. Call to hshkill()
  * calls this function, which contains details as to how objects of type 
  * varMap is to be deallocated.
@@ -304,6 +382,8 @@ int readVariables(char* filename,hshtbl* varTable){
 	char* single_line;
 	varMapP var;
 	varMapP varToFind;
+	phaseClock timer = startPhase();
+	unsigned long probes = hshstatus(varTable).probes;
 	
 	/*Open first file and read the contents*/		
 	if ((fp = fopen(filename,"r")) == NULL){
@@ -321,6 +401,7 @@ int readVariables(char* filename,hshtbl* varTable){
 				fclose(fp);
 				fp=NULL;
 			}
+			stopPhase(timer, &engineStats.parseWall, &engineStats.parseCpu);
 			return 1;
 		}
 		while(single_line!=NULL){
@@ -348,8 +429,11 @@ int readVariables(char* filename,hshtbl* varTable){
 			}
 			else;
 		}
+		engineStats.hashProbes += hshstatus(varTable).probes - probes;
+		stopPhase(timer, &engineStats.parseWall, &engineStats.parseCpu);
 		return 0;
 	}
+	stopPhase(timer, &engineStats.parseWall, &engineStats.parseCpu);
 	return 1;
 }
 
@@ -403,6 +487,8 @@ void printVariables(hshtbl* varTable){
 int push(stackP eqnStack,redouble operand){
 	if (eqnStack->topOfStack<MAX_STACK_SIZE){
 		eqnStack->element[eqnStack->topOfStack++]=operand;
+		if (eqnStack->topOfStack > engineStats.stackHighWater)
+			engineStats.stackHighWater = eqnStack->topOfStack;
 		return 0;
 	}
 	else{
@@ -465,7 +551,6 @@ int killStack(stackP eqnStack){
  * */
 double evaluate(Equation* eqn,hshtbl* vars){
 	Equation* head = eqn;
-	varMap var;
 	varMapP locVar;
 	double result;
 	hshtbl* varTable=vars;
@@ -473,14 +558,22 @@ double evaluate(Equation* eqn,hshtbl* vars){
 	redouble* operand1;
 	redouble* operand2;
 	stackP operandStack = createStack();
+	phaseClock timer = startPhase();
+	traceptr = trace;
+	dirtyCount = 0;
+	hshwalk(varTable, clearEachUse, NULL);
+	memset(engineStats.nodes, 0, sizeof(engineStats.nodes));
 	while (head!=NULL){
+		if (head->type >= emptyv && head->type <= funcv)
+			engineStats.nodes[head->type]++;
 		switch(head->type){
 			case constv:
 				push(operandStack,makeConstv((strtod(head->token,NULL)),NULL));
 				break;
 			case indepv:
-				var.key=head->token;
-				locVar=hshfind(varTable,&var);
+				locVar=(varMapP) head->var;
+				traceptr->nextUse = locVar->uses;
+				locVar->uses = (struct elements*) traceptr;
 				push(operandStack,makeIndepv((locVar->value),head->token));
 				break;
 			case bplusv:
@@ -492,6 +585,7 @@ double evaluate(Equation* eqn,hshtbl* vars){
 				traceptr->operation = bplusv;
 				traceptr->arg1 = (struct elements*) operand1->ref;
 				traceptr->arg2 = (struct elements*) operand2->ref;
+				linkArguments(traceptr);
 				traceptr++;
 				push(operandStack,temp);
 				break;
@@ -504,6 +598,7 @@ double evaluate(Equation* eqn,hshtbl* vars){
 				traceptr->operation = bminusv;
 				traceptr->arg1 = (struct elements*) operand1->ref;
 				traceptr->arg2 = (struct elements*) operand2->ref;
+				linkArguments(traceptr);
 				traceptr++;
 				push(operandStack,temp);
 				break;
@@ -516,6 +611,7 @@ double evaluate(Equation* eqn,hshtbl* vars){
 				traceptr->operation = bmultv;
 				traceptr->arg1 = (struct elements*) operand1->ref;
 				traceptr->arg2 = (struct elements*) operand2->ref;
+				linkArguments(traceptr);
 				traceptr++;
 				push(operandStack,temp);
 				break;
@@ -533,6 +629,7 @@ double evaluate(Equation* eqn,hshtbl* vars){
 				traceptr->operation = divv;
 				traceptr->arg1 = (struct elements*) operand1->ref;
 				traceptr->arg2 = (struct elements*) operand2->ref;
+				linkArguments(traceptr);
 				traceptr++;
 				push(operandStack,temp);
 				break;
@@ -543,6 +640,8 @@ double evaluate(Equation* eqn,hshtbl* vars){
 				traceptr->bar = 0.0;
 				traceptr->operation = sinv;
 				traceptr->arg1 = (struct elements*) operand1->ref;
+				traceptr->arg2 = NULL;
+				linkArguments(traceptr);
 				traceptr++;
 				push(operandStack,temp);
 				break;
@@ -555,6 +654,7 @@ double evaluate(Equation* eqn,hshtbl* vars){
 				traceptr->operation = powv;
 				traceptr->arg1 = (struct elements*) operand1->ref;
 				traceptr->arg2 = (struct elements*) operand2->ref;
+				linkArguments(traceptr);
 				traceptr++;
 				push(operandStack,temp);
 				break;
@@ -567,6 +667,7 @@ double evaluate(Equation* eqn,hshtbl* vars){
 				traceptr->operation = bminusv;
 				traceptr->arg1 = (struct elements*) operand1->ref;
 				traceptr->arg2 = (struct elements*) operand2->ref;
+				linkArguments(traceptr);
 				traceptr++;
 				push(operandStack,temp);
 				break;			
@@ -577,9 +678,18 @@ double evaluate(Equation* eqn,hshtbl* vars){
 	}
 	result = ((operandStack->element[0]).ref)->val;
 	killStack(operandStack);
+	engineStats.traceBytes = (traceptr - trace) * sizeof(elements);
+	stopPhase(timer, &engineStats.forwardWall, &engineStats.forwardCpu);
 	return result;		
 }
 
+/* Description: This function returns the number of entries in the trace
+ * recorded by the last call to evaluate.
+ * */
+int getTraceLength(){
+	return traceptr - trace;
+}
+
 /* Description: This function is used to print the contents of an existing
  * stack. Its used for debugging purpose.
  * Arguments: The pointer to the stack that is to be printed.
@@ -607,6 +717,14 @@ int reverseSweep(){
   double combibar;
   
   elements* tracer = traceptr;
+  phaseClock timer = startPhase();
+  
+  /* Clear the adjoints of an earlier sweep. The root keeps its seed */
+  while (--tracer >= trace){
+  	if (tracer->parent != NULL)
+  		tracer->bar = 0.0;
+  }
+  tracer = traceptr;
   
   while (--tracer > trace){
   
@@ -662,6 +780,7 @@ int reverseSweep(){
   	} 
   }
   
+  stopPhase(timer, &engineStats.reverseWall, &engineStats.reverseCpu);
   return 0;
 }
 
@@ -688,6 +807,8 @@ redouble makeIndepv(double value,char* varName){
 	traceptr->bar = 0.0;
 	traceptr->operation = indepv;
 	traceptr->varName = varName;
+	traceptr->parent = NULL;
+	traceptr->dirty = 0;
 	traceptr++;
 	return temp;
 }
@@ -711,10 +832,471 @@ redouble makeConstv(double value,char* varName){
 	traceptr->bar = 0.0;
 	traceptr->operation = constv;
 	traceptr->varName = varName;
+	traceptr->parent = NULL;
+	traceptr->nextUse = NULL;
+	traceptr->dirty = 0;
 	traceptr++;
 	return temp;
 }
 
+/* Description: This function records the forward dependency of a newly
+ * made trace entry on its arguments. Every trace entry is consumed by
+ * exactly one operation, so the dependency is kept as a parent pointer.
+ * Arguments: node is the trace entry whose arg1 and arg2 (NULL for unary
+ * operations) have already been set.
+ * */
+void linkArguments(elements* node){
+	node->parent = NULL;
+	node->nextUse = NULL;
+	node->dirty = 0;
+	((elements*)(node->arg1))->parent = (struct elements*) node;
+	if (node->arg2 != NULL)
+		((elements*)(node->arg2))->parent = (struct elements*) node;
+}
+
+/* Description: This function is called by hshwalk() from evaluate to
+ * forget the trace entries recorded for a variable by an earlier
+ * evaluation.
+ * Return: This function returns 0 for hashwalk to walk throught the next
+ * item in varMap.
+ * */
+int clearEachUse(void* varItem, void* data, void* extra){
+	((varMap*)(varItem))->uses = NULL;
+	return 0;
+}
+
+/* Description: This function changes the value of a variable after the
+ * trace has been built by evaluate. Each indepv trace entry of the
+ * variable gets the new value, and it and all the entries above it up to
+ * the root are queued for reevaluate(). The walk stops at an entry that
+ * is already queued, so the queue holds the forward cone of all the
+ * variables changed since the last reevaluate() exactly once.
+ * Arguments: varTable is the table of variables, varName the name of the
+ * variable and value its new value.
+ * Return: 0 on success
+ * 		   1 if the variable is not in the table
+ * */
+int setVariable(hshtbl* varTable, char* varName, double value){
+	varMap var;
+	varMapP locVar;
+	elements* use;
+	elements* node;
+	
+	unsigned long probes = hshstatus(varTable).probes;
+	
+	var.key = varName;
+	locVar = hshfind(varTable, &var);
+	engineStats.hashProbes += hshstatus(varTable).probes - probes;
+	if (locVar == NULL)
+		return 1;
+	if (locVar->value == value)
+		return 0;
+	locVar->value = value;
+	for (use = (elements*) locVar->uses; use != NULL; use = (elements*) use->nextUse){
+		use->val = value;
+		node = (elements*) use->parent;
+		while (node != NULL && !node->dirty){
+			node->dirty = 1;
+			dirtyTrace[dirtyCount++] = node;
+			node = (elements*) node->parent;
+		}
+	}
+	return 0;
+}
+
+/* Description: This function is used by qsort in reevaluate to order the
+ * dirty trace entries the way they were recorded, which ensures the
+ * arguments of an entry are recomputed before the entry itself.
+ * */
+int compareTraceOrder(const void* left, const void* right){
+	elements* l = *(elements* const*) left;
+	elements* r = *(elements* const*) right;
+	return (l > r) - (l < r);
+}
+
+/* Description: This function recomputes the value of one trace entry from
+ * the values of its arguments. It mirrors the forward computations done
+ * in evaluate.
+ * Arguments: The trace entry that has to be recomputed.
+ * Returns: Exits with 1 on divide by zero and returns 0 on success
+ * */
+int recomputeElement(elements* node){
+	double arg1val = ((elements*)(node->arg1))->val;
+	double arg2val = 0.0;
+	
+	if (node->arg2 != NULL)
+		arg2val = ((elements*)(node->arg2))->val;
+	switch (node->operation){
+		case bplusv:
+			node->val = arg1val + arg2val;
+			break;
+		case bminusv:
+			node->val = arg1val - arg2val;
+			break;
+		case bmultv:
+			node->val = arg1val * arg2val;
+			break;
+		case divv:
+			if (arg2val!=0)
+				node->val = arg1val / arg2val;
+			else{
+				printf("Divide by Zero Error\n");
+				exit(1);
+			}
+			break;
+		case sinv:
+			node->val = sin(arg1val);
+			break;
+		case powv:
+			node->val = pow(arg1val, arg2val);
+			break;
+		default:
+			break;
+	}
+	return 0;
+}
+
+/* Description: This function recomputes the trace entries queued by
+ * setVariable(). The cost is proportional to the size of the forward cone
+ * of the changed variables rather than to the size of the equation.
+ * evaluateFirstPartials() can be called afterwards for the new gradient.
+ * Returns: The function value at the new operating point.
+ * */
+double reevaluate(){
+	int i;
+	phaseClock timer = startPhase();
+	
+	qsort(dirtyTrace, dirtyCount, sizeof(elements*), compareTraceOrder);
+	for (i = 0; i < dirtyCount; i++){
+		recomputeElement(dirtyTrace[i]);
+		dirtyTrace[i]->dirty = 0;
+	}
+	dirtyCount = 0;
+	stopPhase(timer, &engineStats.forwardWall, &engineStats.forwardCpu);
+	return (traceptr - 1)->val;
+}
+
+/* Description: This function is called by hshwalk() from forwardReplay.
+ * It gives the variable and each of its indepv trace entries the next
+ * value from the vector held in data.
+ * Return: This function returns 0 for hashwalk to walk throught the next
+ * item in varMap.
+ * */
+int replayEachVariable(void* varItem, void* data, void* extra){
+	varMapP var = varItem;
+	replayData* replay = data;
+	elements* use;
+	
+	var->value = replay->values[replay->index++];
+	for (use = (elements*) var->uses; use != NULL; use = (elements*) use->nextUse)
+		use->val = var->value;
+	return 0;
+}
+
+/* Description: This function replays the trace recorded by the last call
+ * to evaluate at a new operating point, without parsing, hashing or
+ * allocating. Every computed trace entry is recomputed in place in the
+ * order it was recorded; constants keep their values.
+ * Arguments: varTable is the table used by evaluate. values holds the new
+ * value of each variable in the order hshwalk() visits varTable, which is
+ * also the order of the names reported by evaluateFirstPartials. The
+ * order holds as long as no variable is inserted or deleted.
+ * Returns: The function value at the new operating point.
+ * */
+double forwardReplay(hshtbl* varTable, double* values){
+	replayData replay;
+	elements* tracer;
+	int i;
+	phaseClock timer = startPhase();
+	
+	replay.values = values;
+	replay.index = 0;
+	hshwalk(varTable, replayEachVariable, &replay);
+	for (tracer = trace; tracer < traceptr; tracer++){
+		if (tracer->operation != indepv && tracer->operation != constv)
+			recomputeElement(tracer);
+	}
+	for (i = 0; i < dirtyCount; i++)
+		dirtyTrace[i]->dirty = 0;
+	dirtyCount = 0;
+	stopPhase(timer, &engineStats.forwardWall, &engineStats.forwardCpu);
+	return (traceptr - 1)->val;
+}
+
+/* Description: This function is called by hshwalk() from reverseReplay.
+ * It sums the adjoints of the indepv trace entries of the variable into
+ * the next slot of the vector held in data.
+ * Return: This function returns 0 for hashwalk to walk throught the next
+ * item in varMap.
+ * */
+int gatherEachAdjoint(void* varItem, void* data, void* extra){
+	varMapP var = varItem;
+	replayData* replay = data;
+	elements* use;
+	double sum = 0.0;
+	
+	for (use = (elements*) var->uses; use != NULL; use = (elements*) use->nextUse)
+		sum += use->bar;
+	replay->values[replay->index++] = sum;
+	return 0;
+}
+
+/* Description: This function is the reverse counterpart of forwardReplay.
+ * It sweeps the same trace and writes the first partials into a vector
+ * supplied by the caller instead of allocating a firstPartials object.
+ * Arguments: varTable is the table used by evaluate. partials receives
+ * one value per variable, in the same order as for forwardReplay.
+ * Returns: 0 on success
+ * */
+int reverseReplay(hshtbl* varTable, double* partials){
+	replayData replay;
+	phaseClock timer;
+	
+	reverseSweep();
+	timer = startPhase();
+	replay.values = partials;
+	replay.index = 0;
+	hshwalk(varTable, gatherEachAdjoint, &replay);
+	stopPhase(timer, &engineStats.reverseWall, &engineStats.reverseCpu);
+	return 0;
+}
+
+/* Description: This function is called by hshwalk() from
+ * forwardReplayBatch. It copies the next row of lanes from the vector
+ * held in data into the rows of each indepv trace entry of the variable.
+ * Return: This function returns 0 for hashwalk to walk throught the next
+ * item in varMap.
+ * */
+int replayBatchEachVariable(void* varItem, void* data, void* extra){
+	varMapP var = varItem;
+	replayData* replay = data;
+	elements* use;
+	double* row = replay->values + (replay->index++) * batchLanes;
+	
+	for (use = (elements*) var->uses; use != NULL; use = (elements*) use->nextUse)
+		memcpy(batchVal + (use - trace) * batchLanes, row, sizeof(double) * batchLanes);
+	return 0;
+}
+
+/* Description: This function replays the recorded trace at lanes
+ * operating points at once. Each trace entry is computed for all lanes
+ * before moving to the next, so the loops run over contiguous memory and
+ * sin and pow go through the vector kernels of vecmath.c.
+ * Arguments: varTable is the table used by evaluate. values holds one row
+ * of lanes values per variable, the rows in the order hshwalk() visits
+ * varTable (see forwardReplay).
+ * Returns: The function values, one per lane. The storage belongs to the
+ * batch and stays valid until the next batch replay or killBatch().
+ * Exits with 1 on divide by zero or when out of memory.
+ * */
+double* forwardReplayBatch(hshtbl* varTable, double* values, int lanes){
+	replayData replay;
+	elements* tracer;
+	double* row;
+	double* arg1row;
+	double* arg2row;
+	int size = (traceptr - trace) * lanes;
+	int i;
+	phaseClock timer = startPhase();
+	
+	if (size > batchCapacity || lanes > batchLanes){
+		killBatch();
+		batchVal = (double*) malloc(sizeof(double) * size);
+		batchBar = (double*) malloc(sizeof(double) * size);
+		batchTemp = (double*) malloc(sizeof(double) * 2 * lanes);
+		if (batchVal == NULL || batchBar == NULL || batchTemp == NULL){
+			fprintf(stderr,"Memory Error");
+			exit(1);
+		}
+		batchCapacity = size;
+	}
+	batchLanes = lanes;
+	replay.values = values;
+	replay.index = 0;
+	hshwalk(varTable, replayBatchEachVariable, &replay);
+	for (tracer = trace, row = batchVal; tracer < traceptr; tracer++, row += lanes){
+		if (tracer->operation == indepv)
+			continue;
+		if (tracer->operation == constv){
+			for (i = 0; i < lanes; i++)
+				row[i] = tracer->val;
+			continue;
+		}
+		arg1row = batchVal + ((elements*)(tracer->arg1) - trace) * lanes;
+		arg2row = arg1row;
+		if (tracer->arg2 != NULL)
+			arg2row = batchVal + ((elements*)(tracer->arg2) - trace) * lanes;
+		switch (tracer->operation){
+			case bplusv:
+				for (i = 0; i < lanes; i++)
+					row[i] = arg1row[i] + arg2row[i];
+				break;
+			case bminusv:
+				for (i = 0; i < lanes; i++)
+					row[i] = arg1row[i] - arg2row[i];
+				break;
+			case bmultv:
+				for (i = 0; i < lanes; i++)
+					row[i] = arg1row[i] * arg2row[i];
+				break;
+			case divv:
+				for (i = 0; i < lanes; i++){
+					if (arg2row[i] == 0){
+						printf("Divide by Zero Error\n");
+						exit(1);
+					}
+				}
+				for (i = 0; i < lanes; i++)
+					row[i] = arg1row[i] / arg2row[i];
+				break;
+			case sinv:
+				vecSin(arg1row, row, lanes);
+				break;
+			case powv:
+				vecPow(arg1row, arg2row, row, lanes);
+				break;
+			default:
+				break;
+		}
+	}
+	stopPhase(timer, &engineStats.forwardWall, &engineStats.forwardCpu);
+	return batchVal + ((traceptr - trace) - 1) * lanes;
+}
+
+/* Description: This function is called by hshwalk() from
+ * reverseReplayBatch. It sums the adjoint rows of the indepv trace
+ * entries of the variable into the next row of the vector held in data.
+ * Return: This function returns 0 for hashwalk to walk throught the next
+ * item in varMap.
+ * */
+int gatherBatchEachAdjoint(void* varItem, void* data, void* extra){
+	varMapP var = varItem;
+	replayData* replay = data;
+	elements* use;
+	double* row = replay->values + (replay->index++) * batchLanes;
+	double* bar;
+	int i;
+	
+	for (i = 0; i < batchLanes; i++)
+		row[i] = 0.0;
+	for (use = (elements*) var->uses; use != NULL; use = (elements*) use->nextUse){
+		bar = batchBar + (use - trace) * batchLanes;
+		for (i = 0; i < batchLanes; i++)
+			row[i] += bar[i];
+	}
+	return 0;
+}
+
+/* Description: This function is the reverse counterpart of
+ * forwardReplayBatch. It is the reverseSweep of every lane at once, with
+ * the cos, pow and log of the sin and pow adjoints going through the
+ * vector kernels of vecmath.c.
+ * Arguments: varTable is the table used by evaluate. partials receives
+ * one row of lanes first partials per variable, in the same order as the
+ * rows given to forwardReplayBatch.
+ * Returns: 0 on success
+ * 			1 if forwardReplayBatch has not been called
+ * */
+int reverseReplayBatch(hshtbl* varTable, double* partials){
+	replayData replay;
+	elements* tracer;
+	int lanes = batchLanes;
+	int count = traceptr - trace;
+	double* row;
+	double* bar;
+	double* arg1row;
+	double* arg2row;
+	double* arg1bar;
+	double* arg2bar;
+	double* temp1 = batchTemp;
+	double* temp2 = batchTemp + lanes;
+	int i;
+	phaseClock timer;
+	
+	if (batchVal == NULL)
+		return 1;
+	timer = startPhase();
+	for (i = 0; i < count * lanes; i++)
+		batchBar[i] = 0.0;
+	for (i = 0; i < lanes; i++)
+		batchBar[(count - 1) * lanes + i] = (traceptr - 1)->bar;
+	
+	for (tracer = traceptr - 1; tracer >= trace; tracer--){
+		if (tracer->operation == indepv || tracer->operation == constv)
+			continue;
+		row = batchVal + (tracer - trace) * lanes;
+		bar = batchBar + (tracer - trace) * lanes;
+		arg1row = batchVal + ((elements*)(tracer->arg1) - trace) * lanes;
+		arg1bar = batchBar + ((elements*)(tracer->arg1) - trace) * lanes;
+		arg2row = arg1row;
+		arg2bar = arg1bar;
+		if (tracer->arg2 != NULL){
+			arg2row = batchVal + ((elements*)(tracer->arg2) - trace) * lanes;
+			arg2bar = batchBar + ((elements*)(tracer->arg2) - trace) * lanes;
+		}
+		switch (tracer->operation){
+			case bplusv:
+				for (i = 0; i < lanes; i++){
+					arg1bar[i] += bar[i];
+					arg2bar[i] += bar[i];
+				}
+				break;
+			case bminusv:
+				for (i = 0; i < lanes; i++){
+					arg1bar[i] += bar[i];
+					arg2bar[i] -= bar[i];
+				}
+				break;
+			case bmultv:
+				for (i = 0; i < lanes; i++){
+					arg1bar[i] += bar[i] * arg2row[i];
+					arg2bar[i] += bar[i] * arg1row[i];
+				}
+				break;
+			case divv:
+				for (i = 0; i < lanes; i++){
+					arg1bar[i] += bar[i] * (1 / arg2row[i]);
+					arg2bar[i] += bar[i] * ((-arg1row[i]) / (arg2row[i] * arg2row[i]));
+				}
+				break;
+			case sinv:
+				vecCos(arg1row, temp1, lanes);
+				for (i = 0; i < lanes; i++)
+					arg1bar[i] += bar[i] * temp1[i];
+				break;
+			case powv:
+				for (i = 0; i < lanes; i++)
+					temp1[i] = arg2row[i] - 1;
+				vecPow(arg1row, temp1, temp2, lanes);
+				vecLog(arg1row, temp1, lanes);
+				for (i = 0; i < lanes; i++){
+					arg1bar[i] += bar[i] * (arg2row[i] * temp2[i]);
+					arg2bar[i] += bar[i] * (row[i] * temp1[i]);
+				}
+				break;
+			default:
+				break;
+		}
+	}
+	
+	replay.values = partials;
+	replay.index = 0;
+	hshwalk(varTable, gatherBatchEachAdjoint, &replay);
+	stopPhase(timer, &engineStats.reverseWall, &engineStats.reverseCpu);
+	return 0;
+}
+
+/* Description: This function releases the lanes of the batch replay.
+ * */
+void killBatch(){
+	free(batchVal);
+	free(batchBar);
+	free(batchTemp);
+	batchVal = batchBar = batchTemp = NULL;
+	batchCapacity = 0;
+	batchLanes = 0;
+}
+
 /* Description: This function is used to accumulate the partial adjoints
  * that are calculated during the return trace phase. This function is called
  * by hshwalk() from Hashlib which in turn is called by evaluateFirstPartials.
@@ -726,18 +1308,16 @@ redouble makeConstv(double value,char* varName){
  * item in varMap.
  * */
 int sumEachAdjoint(void* varItem, void* data, void* extra){
-	int i=0;
-	elements* tracer = traceptr;
-	*((((firstPartials*) data)->partials) + (((firstPartials*)data)->index)) = 0.0;
-	*((((firstPartials*) data)->varName) + (((firstPartials*)data)->index)) = ((varMap*)(varItem))->key;
-	while(--tracer > trace){
-			if (tracer->operation == indepv){
-				if((strcmp(((varMap*)(varItem))->key, tracer->varName))==0){
-					*((((firstPartials*)data)->partials)+(((firstPartials*)data)->index)) += tracer->bar;
-				}
-			}
-	}
-	((firstPartials*)data)->index++;
+	varMapP var = varItem;
+	firstPartials* partials = data;
+	elements* use;
+	double sum = 0.0;
+	
+	for (use = (elements*) var->uses; use != NULL; use = (elements*) use->nextUse)
+		sum += use->bar;
+	partials->partials[partials->index] = sum;
+	partials->varName[partials->index] = var->key;
+	partials->index++;
 	return 0;
 }
 
@@ -752,16 +1332,103 @@ int sumEachAdjoint(void* varItem, void* data, void* extra){
 firstPartials evaluateFirstPartials(hshtbl* varTable){
 	hshtbl* tblToEvaluate = varTable;
 	firstPartials firstPartialAdjoints;
+	phaseClock timer;
 	reverseSweep();
+	timer = startPhase();
 	firstPartialAdjoints.count = getNumberVariables(varTable);
 	firstPartialAdjoints.partials = (double*) malloc(sizeof(double) * firstPartialAdjoints.count);
-	firstPartialAdjoints.varName = (char**) malloc(sizeof(char)*firstPartialAdjoints.count);
+	firstPartialAdjoints.varName = (char**) malloc(sizeof(char*)*firstPartialAdjoints.count);
 	firstPartialAdjoints.index = 0;
 	hshwalk(tblToEvaluate, sumEachAdjoint, &firstPartialAdjoints);
+	stopPhase(timer, &engineStats.reverseWall, &engineStats.reverseCpu);
 	return firstPartialAdjoints;
 }
 
 
+/* Description: This function marks the start of a phase. Wall clock time
+ * comes from the monotonic clock where there is one and from clock()
+ * otherwise; processor time always comes from clock(). Reading the clocks
+ * costs far more than a replay of a small trace, so while timing is off
+ * nothing is read.
+ * Returns: The point in time from which stopPhase() measures, negative
+ * when the phase is not timed.
+ * */
+phaseClock startPhase(){
+	phaseClock now;
+	if (!statsTiming){
+		now.wall = now.cpu = -1.0;
+		return now;
+	}
+#ifdef CLOCK_MONOTONIC
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	now.wall = ts.tv_sec + ts.tv_nsec * 1e-9;
+#else
+	now.wall = (double) clock() / CLOCKS_PER_SEC;
+#endif
+	now.cpu = (double) clock() / CLOCKS_PER_SEC;
+	return now;
+}
+
+/* Description: This function adds the time elapsed since start to the
+ * totals of a phase.
+ * Arguments: start is the value returned by startPhase(). wall and cpu
+ * point to the totals of the phase in engineStats.
+ * */
+void stopPhase(phaseClock start, double* wall, double* cpu){
+	phaseClock now;
+	if (start.wall < 0.0 || !statsTiming)
+		return;
+	now = startPhase();
+	*wall += now.wall - start.wall;
+	*cpu += now.cpu - start.cpu;
+}
+
+/* Description: This function returns a copy of the statistics of the
+ * engine. See deStats in DE.h for what each field counts.
+ * */
+deStats getStats(){
+	return engineStats;
+}
+
+/* Description: This function clears the statistics of the engine, for
+ * instance before the equation whose cost is to be measured.
+ * */
+void resetStats(){
+	memset(&engineStats, 0, sizeof(engineStats));
+}
+
+/* Description: This function turns the timing of the phases on or off.
+ * The counters are always kept.
+ * Arguments: on is non-zero to time the phases from the next call on.
+ * */
+void setStatsTiming(int on){
+	statsTiming = on;
+}
+
+/* Description: This function prints the statistics of the engine, one
+ * item per line, in the manner of the table status of hashtest.
+ * Arguments: fp is the stream to print to, e.g. stderr.
+ * */
+void printStats(FILE* fp){
+	int i;
+	
+	fprintf(fp,"Nodes by opcode:\n");
+	for (i = emptyv + 1; i <= funcv; i++){
+		if (engineStats.nodes[i])
+			fprintf(fp,"  %-10s %lu\n", opcodeNames[i], engineStats.nodes[i]);
+	}
+	fprintf(fp,"Trace bytes:      %lu\n", engineStats.traceBytes);
+	fprintf(fp,"Stack high water: %d\n", engineStats.stackHighWater);
+	fprintf(fp,"Hash probes:      %lu\n", engineStats.hashProbes);
+	if (!statsTiming)
+		return;
+	fprintf(fp,"Phase        wall (s)      cpu (s)\n");
+	fprintf(fp,"  parse    %12.6f %12.6f\n", engineStats.parseWall, engineStats.parseCpu);
+	fprintf(fp,"  forward  %12.6f %12.6f\n", engineStats.forwardWall, engineStats.forwardCpu);
+	fprintf(fp,"  reverse  %12.6f %12.6f\n", engineStats.reverseWall, engineStats.reverseCpu);
+}
+
 /* Description: This function deallocates the resources that have been 
  * allocated during the formation of the Equation Linked List.
  * This function has to be called after a call to hshkill()
@@ -28,10 +28,18 @@
 	#include <stdio.h>
 #endif
 
+#ifndef _TIME_H
+	#include <time.h>
+#endif
+
 #ifndef hashlib_h
 	#include "hashlib/hashlib.h"
 #endif
 
+#ifndef _VECMATH_H_
+	#include "vecmath.h"
+#endif
+
 
 /* The maximum number of characters in one line of an input file */
 #ifndef MAX_CHAR_LINE
@@ -74,10 +82,13 @@ typedef enum opcode{
 /* Description: This structure holds the various tokens that form the 
  * equation. It is later used by function evaluate to evaluate the value 
  * of the function.
+ * For a variable, var is its entry in the variable table the equation was
+ * read with and token its interned name, var->key.
  * */
 typedef struct {
 	opcode type;			
 	char* token;
+	struct varMap* var;
 	struct Equation* next;
 }Equation,*EquationP;
 
@@ -86,10 +97,17 @@ typedef struct {
  * variable as a key,value pair. The Hashlib used by this code has been 
  * written by Charles B. Falconer and is licensed under GPL. It has O(1) 
  * storage and retrieval performance.
+ * uses is the head of the chain (linked through nextUse) of the indepv
+ * trace entries that read this variable. It is rebuilt by evaluate().
+ * The table interns the names: key is the one copy of the name shared by
+ * the equation and the trace, so equal names are equal pointers, and id
+ * numbers the variables 0,1,2.. in the order the equation names them.
  * */
 typedef struct{
 	char* key;
 	double value;
+	struct elements* uses;
+	int id;
 }varMap,*varMapP;
 
 
@@ -100,6 +118,8 @@ typedef struct{
  * "Evaluating Derivatives - Principles and Techniques of Algorithmic 
  * Differentiation by Andreas Griewank"
  * and modified suitably.
+ * parent is the trace entry that consumed this one as an argument, which
+ * gives the forward dependency used by setVariable() and reevaluate().
  * */
 typedef struct{
    double val;
@@ -108,6 +128,9 @@ typedef struct{
    opcode operation;
    struct elements *arg1;
    struct elements *arg2;
+   struct elements *parent;
+   struct elements *nextUse;
+   int dirty;
 }elements;
 
 /* Description: This structure is used for maintaining pointer to trace 
@@ -140,6 +163,44 @@ typedef struct{
 	char** varName;
 }firstPartials;
 
+/* Description: This structure is the datum handed by hshwalk() to
+ * replayEachVariable and gatherEachAdjoint. values points to one double
+ * per variable, in the order hshwalk() visits the variable table.
+ * */
+typedef struct{
+	double* values;
+	int index;
+}replayData;
+
+/* Description: This structure holds the statistics of the engine, much
+ * as hshstats does for a table. nodes counts the tokens of each opcode in
+ * the equation last evaluated and traceBytes the storage of its trace.
+ * stackHighWater is the deepest the operand stack has been and hashProbes
+ * the probes of the variable table made by lookups of variables. The
+ * times, in seconds of wall clock and processor time, are only taken
+ * after setStatsTiming(1), and add up over every call: parse covers readEquation and readVariables, forward covers
+ * evaluate, reevaluate and the forward replays, reverse covers
+ * reverseSweep, the gathering of the first partials and the reverse
+ * replays. Everything but nodes and traceBytes adds up until resetStats().
+ * */
+typedef struct{
+	unsigned long nodes[funcv + 1];
+	unsigned long traceBytes;
+	int stackHighWater;
+	unsigned long hashProbes;
+	double parseWall, parseCpu;
+	double forwardWall, forwardCpu;
+	double reverseWall, reverseCpu;
+}deStats;
+
+/* Description: This structure is a point in wall clock and processor time
+ * from which the length of a phase is measured.
+ * */
+typedef struct{
+	double wall;
+	double cpu;
+}phaseClock;
+
 /********* These functions help access and modify the stack **********/
 /* Description: This function is used to push values of type redouble onto
  * the stack during function evaluation phase.
@@ -186,6 +247,11 @@ int varCmp(void*,void*);
  * */
 void* varDup(void*);
 
+/* Description: varArenaDup does the work of varDup for the tables made by
+ * getNewTable(), taking the memory from the table instead of malloc.
+ * */
+void* varArenaDup(void*, hshtbl*);
+
 /* Description: varFree is used to free the allocated memory on the hashmap
  * It is used by Hashlib library. For more details look at hashusage.txt in
  * hashlib folder at the root directory.
@@ -257,6 +323,11 @@ int getNumberVariables(hshtbl*);
  * */
 double evaluate(Equation*, hshtbl*);
 
+/* Description: Returns the number of entries in the trace recorded by the
+ * last call to evaluate().
+ * */
+int getTraceLength();
+
 /* Description: Evaluate dF/d(all-variables) partial derivatives).
  * and return the results as a firstPartials object
  * */
@@ -272,6 +343,91 @@ redouble makeIndepv(double,char*);
  * */
 redouble makeConstv(double,char*);
 
+/* Description: Records the forward dependency of a new trace entry on its
+ * arguments.
+ * */
+void linkArguments(elements*);
+
+/* Description: Used by hshwalk() in evaluate() to forget the trace entries
+ * of a variable from an earlier evaluation.
+ * */
+int clearEachUse(void*, void*, void*);
+
+/* Description: Recomputes the value of one trace entry from its arguments.
+ * */
+int recomputeElement(elements*);
+
+/* Description: Orders trace entries for qsort as they were recorded.
+ * */
+int compareTraceOrder(const void*, const void*);
+
+/* Description: Changes the value of a variable after evaluate() and marks
+ * the forward cone of its trace entries dirty. Returns 1 if the variable
+ * is not in the table, 0 otherwise.
+ * */
+int setVariable(hshtbl*, char*, double);
+
+/* Description: Recomputes only the trace entries marked dirty by
+ * setVariable() and returns the new function value.
+ * */
+double reevaluate();
+
+/* Description: Replays the recorded trace at the new operating point given
+ * by a vector of variable values in hshwalk() order, and returns the new
+ * function value.
+ * */
+double forwardReplay(hshtbl*, double*);
+int replayEachVariable(void*, void*, void*);
+
+/* Description: Reverse sweep over the replayed trace. Writes the first
+ * partials into the caller's vector in the same order as forwardReplay.
+ * */
+int reverseReplay(hshtbl*, double*);
+int gatherEachAdjoint(void*, void*, void*);
+
+/* Description: Replays the recorded trace at many operating points at once.
+ * values holds one row of lanes per variable in hshwalk() order. Returns
+ * the function value of each lane.
+ * */
+double* forwardReplayBatch(hshtbl*, double*, int);
+int replayBatchEachVariable(void*, void*, void*);
+
+/* Description: Reverse sweep of every lane of the last batch replay. Writes
+ * one row of lanes of first partials per variable.
+ * */
+int reverseReplayBatch(hshtbl*, double*);
+int gatherBatchEachAdjoint(void*, void*, void*);
+
+/* Description: Releases the storage of the batch replay.
+ * */
+void killBatch();
+
+/* Description: Returns the statistics of the engine gathered since the
+ * last resetStats().
+ * */
+deStats getStats();
+
+/* Description: Clears the statistics of the engine.
+ * */
+void resetStats();
+
+/* Description: Turns the timing of the phases on (non-zero) or off, the
+ * default. Timing reads the clocks at every call, which costs more than a
+ * replay of a small trace.
+ * */
+void setStatsTiming(int);
+
+/* Description: Prints the statistics of the engine to a stream.
+ * */
+void printStats(FILE*);
+
+/* Description: Starts and stops the timing of a phase. stopPhase() adds
+ * the time since startPhase() to the wall and processor time given. Both
+ * do nothing while timing is off.
+ * */
+phaseClock startPhase();
+void stopPhase(phaseClock, double*, double*);
+
 /* Description: Returns a new table to hold key,value pairs for variables.
  * */
 hshtbl* getNewTable();
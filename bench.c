@@ -0,0 +1,306 @@
+/******************************************************************
+* Author: Mahesh Narayanamurthi
+* e- Mail : mahesh.mach@gmail.com
+* Description: Differentiation Exercise -  GSoC
+* Created with: Geany
+* Libraries: Hashlib by Charles B. Falconer
+* Benchmark of the phases of DE.c on large random equations
+******************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/resource.h>
+#include "hashlib/hashlib.h"
+#include "hashlib/cokusmt.h"
+#include "DE.h"
+
+/* The deepest the generated postfix equation may grow the stack */
+#define MAX_GEN_DEPTH (MAX_STACK_SIZE/2)
+
+/* The largest magnitude a product or quotient may be known to reach; an
+ * operation that could exceed it is generated as a + instead */
+#define MAX_GEN_BOUND 1e6
+
+/* Description: The opcodes the generator draws from, in the order their
+ * weights are given with -m.
+ * */
+#define NUM_GEN_OPS 6
+static const char* genTokens[NUM_GEN_OPS] = {"+", "-", "*", "/", "sin", "pow"};
+
+/* Description: One entry of the generator's shadow of the evaluation
+ * stack. A leaf generated with a strictly positive value may be used as
+ * a divisor or as either argument of pow without risking a divide by
+ * zero or an overflow. bound is an upper bound of the magnitude of the
+ * entry's value, so products of products cannot grow without limit.
+ * */
+typedef struct{
+	int safeLeaf;
+	double bound;
+}genEntry;
+
+/* Description: Returns a uniform random number in [0,1) from the
+ * Mersenne Twister of hashlib, which makes the equations reproducible
+ * from the seed.
+ * */
+static double uniform(){
+	return randomMT() / 4294967296.0;
+}
+
+/* Description: Writes a random equation of about nodes trace entries over
+ * numVars variables to eqnName, and a value for every variable the
+ * equation names to varName. The equation is built in postfix order and
+ * written reversed, root first, since readEquation reverses the lines
+ * back into the postfix trace. Leaves are variables, or constants with
+ * probability constPct percent. weights gives the relative frequency of
+ * the operations in genTokens.
+ * Returns: 0 on success, 1 on an IO error.
+ * */
+static int generate(char* eqnName, char* varName, long nodes, long numVars,
+					int constPct, int* weights){
+	char** tokens;
+	genEntry* stack;
+	char* used;
+	double bound;
+	long var;
+	long count = 0;
+	long i;
+	int depth = 0;
+	int totalWeight = 0;
+	int op;
+	int pick;
+	FILE* fp;
+
+	for (op = 0; op < NUM_GEN_OPS; op++)
+		totalWeight += weights[op];
+	tokens = (char**) malloc(sizeof(char*) * (nodes + 2));
+	stack = (genEntry*) malloc(sizeof(genEntry) * (MAX_GEN_DEPTH + 2));
+	used = (char*) calloc(numVars, 1);
+	if (tokens == NULL || stack == NULL || used == NULL){
+		fprintf(stderr,"Memory Error");
+		exit(1);
+	}
+
+	/* Postfix order; the remaining budget has to leave room to reduce the
+	 * stack to one entry and apply the final = */
+	while (count < nodes - 2 || depth > 1){
+		int wantLeaf = depth < 2
+			|| (depth < MAX_GEN_DEPTH && count + depth < nodes - 2 && uniform() < 0.5);
+
+		tokens[count] = (char*) malloc(MAX_CHAR_LINE);
+		if (wantLeaf){
+			if (uniform() * 100 < constPct)
+				sprintf(tokens[count], "constant %.6f", 0.5 + uniform());
+			else{
+				var = (long)(uniform() * numVars);
+				used[var] = 1;
+				sprintf(tokens[count], "variable x_%06ld", var);
+			}
+			/* every leaf value is in [0.5,1.5) */
+			stack[depth].safeLeaf = 1;
+			stack[depth++].bound = 1.5;
+		}
+		else{
+			pick = (int)(uniform() * totalWeight);
+			for (op = 0; pick >= weights[op]; op++)
+				pick -= weights[op];
+			/* only leaves are known to be safe divisors and pow arguments */
+			if (op == 3 && !stack[depth - 2].safeLeaf)
+				op = 2;
+			if (op == 5 && !(stack[depth - 1].safeLeaf && stack[depth - 2].safeLeaf))
+				op = 0;
+			if (op == 4 && count + depth >= nodes - 2)
+				op = 0;
+			/* the top of the stack is the first operand, the one below it
+			 * the divisor or the exponent */
+			if (op == 2)
+				bound = stack[depth - 1].bound * stack[depth - 2].bound;
+			else if (op == 3)
+				bound = stack[depth - 1].bound * 2;
+			else
+				bound = 0;
+			if (bound > MAX_GEN_BOUND)
+				op = 0;
+			if (op == 0 || op == 1)
+				bound = stack[depth - 1].bound + stack[depth - 2].bound;
+			else if (op == 4)
+				bound = 1;
+			else if (op == 5)
+				bound = 2;
+			strcpy(tokens[count], genTokens[op]);
+			if (op != 4)
+				depth--;
+			stack[depth - 1].safeLeaf = 0;
+			stack[depth - 1].bound = bound;
+		}
+		count++;
+	}
+	tokens[count] = (char*) malloc(MAX_CHAR_LINE);
+	strcpy(tokens[count++], "constant 0.0");
+	tokens[count] = (char*) malloc(MAX_CHAR_LINE);
+	strcpy(tokens[count++], "=");
+
+	if ((fp = fopen(eqnName, "w")) == NULL)
+		return 1;
+	for (i = count - 1; i >= 0; i--){
+		fprintf(fp, "%s\n", tokens[i]);
+		free(tokens[i]);
+	}
+	fclose(fp);
+	free(tokens);
+	free(stack);
+
+	if ((fp = fopen(varName, "w")) == NULL)
+		return 1;
+	for (i = 0; i < numVars; i++)
+		if (used[i])
+			fprintf(fp, "x_%06ld %.6f\n", i, 0.5 + uniform());
+	fclose(fp);
+	free(used);
+	return 0;
+}
+
+/* Description: Returns the wall clock time in seconds.
+ * */
+static double wallTime(){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Description: Prints one phase of the report.
+ * */
+static void reportPhase(const char* name, double seconds, long nodes, int last){
+	printf("    \"%s\": {\"seconds\": %.9f, \"ns_per_node\": %.3f}%s\n",
+		name, seconds, seconds * 1e9 / nodes, last ? "" : ",");
+}
+
+static void usage(){
+	fprintf(stderr,"Usage: bench [-n nodes] [-v variables] [-c constant%%]\n"
+		"             [-m w+,w-,w*,w/,wsin,wpow] [-s seed] [-k]\n"
+		"  Times readEquation, readVariables, evaluate, reverseSweep and\n"
+		"  gradient gathering on a random equation and prints JSON.\n"
+		"  -k keeps the generated files. DE.c has to be built with\n"
+		"  MAX_TRACE_SIZE larger than the number of nodes.\n");
+}
+
+int main(int argc, char** argv){
+	long nodes = 100000;
+	long numVars = 100;
+	int constPct = 20;
+	int weights[NUM_GEN_OPS] = {30, 20, 25, 10, 10, 5};
+	unsigned long seed = 4357;
+	int keep = 0;
+	char eqnName[] = "/tmp/bench_eqnXXXXXX";
+	char varName[] = "/tmp/bench_varXXXXXX";
+	double t0, t1, tEqn, tVar, tEval, tSweep, tGather;
+	Equation* eqn;
+	hshtbl* varTable;
+	firstPartials partials;
+	struct rusage resources;
+	double value;
+	long length;
+	int opt;
+	int fd;
+	int i;
+
+	while ((opt = getopt(argc, argv, "n:v:c:m:s:kh")) != -1){
+		switch (opt){
+			case 'n': nodes = strtol(optarg, NULL, 0); break;
+			case 'v': numVars = strtol(optarg, NULL, 0); break;
+			case 'c': constPct = atoi(optarg); break;
+			case 'm':
+				if (sscanf(optarg, "%d,%d,%d,%d,%d,%d", &weights[0], &weights[1],
+						&weights[2], &weights[3], &weights[4], &weights[5]) != NUM_GEN_OPS){
+					usage();
+					return 1;
+				}
+				break;
+			case 's': seed = strtoul(optarg, NULL, 0); break;
+			case 'k': keep = 1; break;
+			default: usage(); return 1;
+		}
+	}
+	if (nodes < 3 || nodes > MAX_TRACE_SIZE - MAX_GEN_DEPTH || numVars < 1 || numVars > 9999999){
+		fprintf(stderr,"nodes must be in 3..%d (MAX_TRACE_SIZE) and variables in 1..9999999\n",
+			MAX_TRACE_SIZE - MAX_GEN_DEPTH);
+		return 1;
+	}
+	for (i = 0; i < NUM_GEN_OPS && weights[i] == 0; i++)
+		;
+	if (i == NUM_GEN_OPS){
+		usage();
+		return 1;
+	}
+
+	if ((fd = mkstemp(eqnName)) < 0 || close(fd) || (fd = mkstemp(varName)) < 0 || close(fd)){
+		fprintf(stderr,"IO Error: temporary files could not be created\n");
+		return 1;
+	}
+	/* seedMT ignores the low bit of its seed, so map every seed to a
+	 * distinct odd one */
+	seedMT(2 * seed + 1);
+	if (generate(eqnName, varName, nodes, numVars, constPct, weights)){
+		fprintf(stderr,"IO Error: equation could not be written\n");
+		return 1;
+	}
+
+	varTable = getNewTable();
+	t0 = wallTime();
+	eqn = readEquation(eqnName, varTable);
+	t1 = wallTime(); tEqn = t1 - t0;
+	readVariables(varName, varTable);
+	t0 = wallTime(); tVar = t0 - t1;
+	value = evaluate(eqn, varTable);
+	t1 = wallTime(); tEval = t1 - t0;
+	reverseSweep();
+	t0 = wallTime(); tSweep = t0 - t1;
+	/* The gathering half of evaluateFirstPartials */
+	partials.count = getNumberVariables(varTable);
+	partials.partials = (double*) malloc(sizeof(double) * partials.count);
+	partials.varName = (char**) malloc(sizeof(char*) * partials.count);
+	partials.index = 0;
+	hshwalk(varTable, sumEachAdjoint, &partials);
+	t1 = wallTime(); tGather = t1 - t0;
+	getrusage(RUSAGE_SELF, &resources);
+	length = getTraceLength();
+
+	printf("{\n");
+	printf("  \"nodes\": %ld,\n", (long)length);
+	printf("  \"variables\": %d,\n", partials.count);
+	printf("  \"seed\": %lu,\n", seed);
+	printf("  \"mix\": {");
+	for (i = 0; i < NUM_GEN_OPS; i++)
+		printf("\"%s\": %d%s", genTokens[i], weights[i], i < NUM_GEN_OPS - 1 ? ", " : "");
+	printf("},\n");
+	printf("  \"constant_percent\": %d,\n", constPct);
+	/* JSON has no infinities or NaNs */
+	if (isfinite(value))
+		printf("  \"value\": %.17g,\n", value);
+	else
+		printf("  \"value\": null,\n");
+	printf("  \"phases\": {\n");
+	reportPhase("readEquation", tEqn, length, 0);
+	reportPhase("readVariables", tVar, length, 0);
+	reportPhase("evaluate", tEval, length, 0);
+	reportPhase("reverseSweep", tSweep, length, 0);
+	reportPhase("gather", tGather, length, 1);
+	printf("  },\n");
+	printf("  \"peak_rss_kb\": %ld\n", resources.ru_maxrss);
+	printf("}\n");
+
+	if (!keep){
+		remove(eqnName);
+		remove(varName);
+	}
+	else
+		fprintf(stderr,"Kept %s and %s\n", eqnName, varName);
+	hshkill(varTable);
+	killEquation(eqn);
+	return 0;
+}
@@ -0,0 +1,250 @@
+/* Timing test for hshconc, the sharded tables.
+
+   Usage: conctest [threads [count]]
+
+   For 1, 2, 4 ... up to threads threads, each inserts its part
+   of count different values, then finds them all.  This is done
+   with one hashlib table behind one mutex, and with a hshconc
+   table of 64 shards.  The rates show how far the inserts scale
+   with the threads, which the single lock cannot.  Lastly one
+   table of count values is walked by hshwalkpar with 1, 2, 4
+   ... threads, adding up the values, to show how the walk
+   scales.
+
+   Needs POSIX threads.  Link with -lpthread.
+*/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include "hashlib.h"
+#include "hshconc.h"
+
+#define MAXTHREADS 64
+#define CACHELINE  64
+
+/* The work of one thread */
+typedef struct work {
+   unsigned long  first, last;  /* values[first..last-1] */
+   unsigned long  found;
+   int            conc;         /* which table */
+} work;
+
+static unsigned long   *values;
+static hshtbl          *single;
+static pthread_mutex_t  singlelock = PTHREAD_MUTEX_INITIALIZER;
+static hshconc         *sharded;
+
+/* 1------------------1 */
+
+static unsigned long vhash(void *item)
+{
+   return *(unsigned long *)item;
+} /* vhash */
+
+/* 1------------------1 */
+
+static unsigned long vrehash(void *item)
+{
+   return *(unsigned long *)item >> 3;
+} /* vrehash */
+
+/* 1------------------1 */
+
+static int vcmp(void *litem, void *ritem)
+{
+   unsigned long l = *(unsigned long *)litem,
+                 r = *(unsigned long *)ritem;
+
+   return (l > r) - (l < r);
+} /* vcmp */
+
+/* 1------------------1 */
+
+static void *vdupe(void *item)
+{
+   unsigned long *v;
+
+   if ((v = malloc(sizeof *v))) *v = *(unsigned long *)item;
+   return v;
+} /* vdupe */
+
+/* 1------------------1 */
+
+static void vundupe(void *item)
+{
+   free(item);
+} /* vundupe */
+
+/* 1------------------1 */
+
+static double now(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec * 1e-9;
+} /* now */
+
+/* 1------------------1 */
+
+static void *inserter(void *arg)
+{
+   work          *w = arg;
+   unsigned long  i;
+
+   for (i = w->first; i < w->last; i++) {
+      if (w->conc) hshconcinsert(sharded, &values[i]);
+      else {
+         pthread_mutex_lock(&singlelock);
+         hshinsert(single, &values[i]);
+         pthread_mutex_unlock(&singlelock);
+      }
+   }
+   return NULL;
+} /* inserter */
+
+/* 1------------------1 */
+
+static void *finder(void *arg)
+{
+   work          *w = arg;
+   unsigned long  i;
+   void          *p;
+
+   for (w->found = 0, i = w->first; i < w->last; i++) {
+      if (w->conc) p = hshconcfind(sharded, &values[i]);
+      else {
+         pthread_mutex_lock(&singlelock);
+         p = hshfind(single, &values[i]);
+         pthread_mutex_unlock(&singlelock);
+      }
+      if (p) w->found++;
+   }
+   return NULL;
+} /* finder */
+
+/* 1------------------1 */
+
+/* The datum of a walk, one per thread, a cache line */
+/* long so that no two threads write the same line   */
+typedef struct tally {
+   unsigned long  items, sum;
+   char           pad[CACHELINE - 2 * sizeof(unsigned long)];
+} tally;
+
+static int addone(void *item, void *datum, void *xtra)
+{
+   tally *t = datum;
+
+   (void)xtra;
+   t->items++;
+   t->sum += *(unsigned long *)item;
+   return 0;
+} /* addone */
+
+static void addtally(void *into, void *from)
+{
+   ((tally *)into)->items += ((tally *)from)->items;
+   ((tally *)into)->sum += ((tally *)from)->sum;
+} /* addtally */
+
+/* 1------------------1 */
+
+/* Run fn in nthreads threads over all count values, */
+/* returning the wall time taken.                    */
+static double run(void *(*fn)(void *), int conc, int nthreads,
+                  unsigned long count, unsigned long *found)
+{
+   pthread_t     tid[MAXTHREADS];
+   work          w[MAXTHREADS];
+   double        t;
+   int           i;
+
+   for (i = 0; i < nthreads; i++) {
+      w[i].first = count / nthreads * i;
+      w[i].last = (i == nthreads - 1) ? count
+                                      : count / nthreads * (i + 1);
+      w[i].conc = conc;
+      w[i].found = 0;
+   }
+   t = now();
+   for (i = 0; i < nthreads; i++)
+      pthread_create(&tid[i], NULL, fn, &w[i]);
+   for (*found = 0, i = 0; i < nthreads; i++) {
+      pthread_join(tid[i], NULL);
+      *found += w[i].found;
+   }
+   return now() - t;
+} /* run */
+
+/* 1------------------1 */
+
+int main(int argc, char **argv)
+{
+   unsigned long count, i, v, found;
+   int           maxthreads, n, conc;
+   double        tins, tfind, t;
+   hshstats      hs;
+   tally         whole, parts[MAXTHREADS];
+
+   maxthreads = (argc > 1) ? atoi(argv[1]) : 8;
+   count = (argc > 2) ? strtoul(argv[2], NULL, 0) : 1000000;
+   if ((maxthreads < 1) || (maxthreads > MAXTHREADS) || !count) {
+      printf("Usage: %s [threads [count]], threads 1..%d\n",
+             argv[0], MAXTHREADS);
+      return EXIT_FAILURE;
+   }
+   if (!(values = malloc(count * sizeof *values))) {
+      printf("No memory\n");
+      return EXIT_FAILURE;
+   }
+   for (i = 0; i < count; i++) {  /* scrambled, all different */
+      v = (i * 2654435761UL) & 0xffffffffUL;
+      v = ((v ^ (v >> 16)) * 0x45d9f3bUL) & 0xffffffffUL;
+      values[i] = v ^ (v >> 16);
+   }
+
+   printf("%lu values\n", count);
+   printf("%-8s%8s%14s%14s\n", "table", "threads",
+          "insert M/s", "find M/s");
+   for (n = 1; n <= maxthreads; n *= 2) {
+      for (conc = 0; conc < 2; conc++) {
+         if (conc) sharded = hshconcinit(vhash, vrehash, vcmp,
+                                         vdupe, vundupe, 0, NULL, 64);
+         else single = hshinit(vhash, vrehash, vcmp,
+                               vdupe, vundupe, 0);
+         tins = run(inserter, conc, n, count, &found);
+         tfind = run(finder, conc, n, count, &found);
+         hs = conc ? hshconcstatus(sharded) : hshstatus(single);
+         printf("%-8s%8d%14.2f%14.2f%s\n", conc ? "sharded" : "single",
+                n, count / tins / 1e6, count / tfind / 1e6,
+                ((found == count) && (hs.hentries == count))
+                ? "" : "  WRONG");
+         if (conc) hshconckill(sharded);
+         else hshkill(single);
+      }
+   }
+
+   single = hshinit(vhash, vrehash, vcmp, vdupe, vundupe, 0);
+   for (i = 0; i < count; i++) hshinsert(single, &values[i]);
+   whole.items = whole.sum = 0;
+   hshwalk(single, addone, &whole);
+   printf("%-8s%8s%14s\n", "walk", "threads", "items M/s");
+   for (n = 1; n <= maxthreads; n *= 2) {
+      for (conc = 0; conc < n; conc++)
+         parts[conc].items = parts[conc].sum = 0;
+      t = now();
+      hshwalkpar(single, n, addone, parts, sizeof parts[0], addtally);
+      t = now() - t;
+      printf("%-8s%8d%14.2f%s\n", "single", n, count / t / 1e6,
+             ((parts[0].items == count) && (parts[0].sum == whole.sum))
+             ? "" : "  WRONG");
+   }
+   hshkill(single);
+   free(values);
+   return 0;
+} /* main */
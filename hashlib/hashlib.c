@@ -53,6 +53,51 @@
                 sensitive to malloc/free performance for large numbers
                 of items, and was done using my nmalloc package.
                 2006-10-22
+  v 1.0.0.3 - Each slot keeps the hash and rehash values of its
+                item.  Probes compare the hashes before calling
+                cmp, and reorganize never calls hash or rehash.
+                Probe sequences, counts and the walk order are
+                unchanged.  No interface changes.
+  v 1.0.0.4 - Added hshinitopts, and the hshINCREMENTAL mode, in
+                which growth moves a few slots per insertion into
+                the new table instead of all of them at once.
+                Lookups consult both tables meanwhile.  hshinit
+                tables behave exactly as before.
+  v 1.0.0.5 - Added hshlookup, a find that writes nothing in the
+                table, for concurrent readers.
+  v 1.0.0.6 - Added hshmemhash and hshmemrehash, which hash a key
+                of given length a machine word at a time.
+  v 1.0.0.7 - Added hshopts.reserve, sizing a new table for that
+                many entries, and hshinsertmany, which grows the
+                table at most once for a whole array of items.
+  v 1.0.0.8 - Added the hshARENA mode and hshaalloc.  Items are
+                copied into slabs owned by the table, which
+                hshkill frees in one sweep, not item by item.
+  v 1.0.0.9 - Added the hshSWISS mode.  A power of 2 table with a
+                control byte per slot, searched a group of 16
+                slots at a time, with SSE2 where available.
+  v 1.0.1.0 - Added the hshROBIN mode.  Robin Hood linear probing,
+                where a delete shifts the following items back,
+                so that there are never DELETED slots.
+  v 1.0.1.1 - Added the hshSMALL mode.  The first few items are
+                kept in slots allocated with the table itself and
+                found by a scan, the hashed layout only being
+                set up when the table outgrows them.
+  v 1.0.1.2 - Added hshfindmany, which hashes a block of keys
+                and prefetches their first slots before searching
+                for any of them, overlapping the cache misses.
+  v 1.0.1.3 - Added hshwalkrange, which walks one of a number of
+                equal parts of the slots and writes nothing, so
+                that threads can walk the parts of one table.
+  v 1.0.1.4 - Table sizes go on to 2**40 where longs have 64
+                bits.  On Linux big slot arrays are mapped with
+                mmap and given transparent huge pages.  No
+                interface changes.
+  v 1.0.1.5 - A hshSMALL table keeps a tag byte per item and
+                matches them all at once, and holds only 8
+                items, beyond which its scan lost to hashing.
+  v 1.0.1.6 - hshfindmany only prefetches in tables of 8 MB of
+                slots or more, below which it cost time.
 
    TODO list:
    Make parameters const where possible
@@ -60,8 +105,22 @@
    Make some better usage examples than the test suite & markov.
 */
 
+/* Define hshNOMMAP to allocate all tables with malloc */
+#if defined(__linux__) && !defined(hshNOMMAP)
+#  define _DEFAULT_SOURCE   /* for MAP_ANONYMOUS, MADV_HUGEPAGE */
+#  define hshMMAP
+#endif
+
 #include <stdlib.h>
+#include <string.h>
+#include <limits.h>
 #include "hashlib.h"
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+#ifdef hshMMAP
+#  include <sys/mman.h>
+#endif
 
 /* Note: version when expressed in decimal, is of the form:  */
 /* M.n.v.p  where  M = Major version                         */
@@ -69,13 +128,29 @@
 /*                 v = variation                             */
 /*                 p = patch                                 */
 /* with all values except M being single decimal digits.     */
-#define VER  1002   /* 1.0.0.2 */
+#define VER  1016   /* 1.0.1.6 */
+
+/* One position in the table.  The hashes of item are kept */
+/* so that a probe can reject a different item without a   */
+/* call to cmp, and so that reorganize never hashes again. */
+/* rehash is only meaningful while item is a stored item.  */
+typedef struct hshslot {
+   void          *item;       /* NULL, DELETED, or an item */
+   unsigned long  hash, rehash;  /* as returned for item   */
+} hshslot;
+
+/* A block of storage handed out by hshaalloc.  The data   */
+/* follows the header, at SLABHDR bytes from its start.     */
+typedef struct hshslab {
+   struct hshslab *next;            /* older slabs */
+   size_t          size, used;      /* bytes of data, handed out */
+} hshslab;
 
 /* This is the entity that remembers all about the database  */
 /* It occurs in the users data space, keeping the system     */
 /* reentrant, because it is passed to all entry routines.    */
 typedef struct hshtag {
-   void*          *htbl;      /* points to an array of void* */
+   hshslot        *htbl;    /* points to an array of slots */
    unsigned long   currentsz;          /* size of that array */
    hshfn           hash, rehash;
    hshcmpfn        cmp;
@@ -83,6 +158,13 @@ typedef struct hshtag {
    hshfreefn       undupe;
    int             hdebug;          /* flag for debug output */
    hshstats        hstatus;  /* statistics, entry ct, errors */
+   unsigned int    mode;          /* hshopts mode, hshmode */
+   hshslot        *oldtbl;  /* being emptied into htbl, or NULL */
+   unsigned long   oldsz;              /* size of that array */
+   unsigned long   oldnext;  /* next index of oldtbl to move */
+   hsharenadupfn   adupe;            /* dupe for hshARENA */
+   hshslab        *arena;  /* slabs, newest first, or NULL */
+   unsigned char  *ctrl;  /* hshSWISS control bytes, or NULL */
 } *hshtblptr;
 
 /* WARN   WARN   WARN   WARN  WARN */
@@ -94,6 +176,43 @@ typedef struct hshtag {
 /* Threshold above which reorganization is desirable */
 #define TTHRESH(sz) (sz - (sz >> 3))
 
+/* hshaalloc hands out multiples of ALIGNSZ bytes, all  */
+/* suitably aligned for any of the members of hshalign. */
+/* A request over SLABSZ / 4 bytes gets a slab its size */
+typedef union hshalign {long l; double d; void *p;} hshalign;
+#define ALIGNSZ sizeof(hshalign)
+#define ROUNDUP(n) (((n) + ALIGNSZ - 1) / ALIGNSZ * ALIGNSZ)
+#define SLABHDR ROUNDUP(sizeof(hshslab))
+#define SLABSZ 65536
+
+/* A hshSMALL table holds up to SMALLMAX items in slots */
+/* just after the master, in the same allocation, then  */
+/* a group of GROUPSZ tag bytes, one per slot.  Beyond  */
+/* about 8 items the scan is slower than the hashed     */
+/* layout, however quick.                               */
+#define SMALLMAX 8
+#define INLINE(m) ((hshslot *)((m) + 1))
+#define INLINETAGS(m) ((unsigned char *)(INLINE(m) + SMALLMAX))
+
+/* Slots of oldtbl moved into htbl per insertion, */
+/* in the hshINCREMENTAL mode                     */
+#define MIGRATESTEP 8
+
+/* Keys hashed and prefetched at a time by hshfindmany.  */
+/* Enough to cover the memory latency, few enough that   */
+/* the first is still in cache when it is searched for.  */
+#define FINDBLOCK 16
+
+/* Bytes of slots below which hshfindmany takes the table */
+/* to be in cache and searches for each key in turn, as   */
+/* the prefetching then only costs time.                  */
+#define PREFETCHMIN (8UL << 20)
+#ifdef __GNUC__
+#  define PREFETCH(p) __builtin_prefetch(p)
+#else
+#  define PREFETCH(p) ((void)(p))
+#endif
+
 /* Space available before reaching threshold */
 /* Ensure this can return a negative value   */
 #define TSPACE(m)  ((long)TTHRESH(m->currentsz) \
@@ -103,13 +222,20 @@ typedef struct hshtag {
 /* These numbers are chosen so that memory allocation will  */
 /* usually allow space for system overhead in a 2**n block  */
 /*http://www.utm.edu/research/primes/lists/2small/0bit.html */
+/* Each k is the least of 41 or more giving a prime.        */
 #define FIRSTN 8
 static int primetbl[] = {45, 45, 41, 45, 45, 45, 45, 49,
                          57, 49, 41, 45, 59, 55, 57, 61,
-                         63, 61, 45, 79, 0};
+                         63, 61, 45, 79,
+#if ULONG_MAX > 4294967295UL
+                         57, 43, 41, 61, 65, 49, 41, 49,
+                         65, 45, 45, 67, 87,
+#endif
+                         0};
 /* So the prime of interest, vs index i into above table,   */
 /* is    ( 2**(FIRSTN + i) ) - primetbl[i]                  */
-/* The above table suffices for about 48,000,000 entries.   */
+/* The above table suffices for about 117,000,000 entries,  */
+/* or with 64 bit longs about 960,000,000,000.              */
 
 /* 1------------------1 */
 
@@ -118,51 +244,232 @@ static int primetbl[] = {45, 45, 41, 45, 45, 45, 45, 49,
 static unsigned long ithprime(size_t i)
 {
    if ((i < sizeof primetbl / sizeof (int)) && (primetbl[i]))
-      return ((1 << (FIRSTN + i)) - primetbl[i]);
+      return ((1UL << (FIRSTN + i)) - primetbl[i]);
    else return 0;
 } /* ithprime */
 
 /* 1------------------1 */
 
+/* Slot arrays and control bytes of BIGTBL bytes or more are */
+/* mapped by mmap where hshMMAP, and marked for transparent  */
+/* huge pages.  A probe into a table far bigger than the     */
+/* cache then misses in the cache, but seldom in the TLB as  */
+/* well.  The pages only get memory when first written, and  */
+/* they go back to the system as soon as the table is freed. */
+#define BIGTBL (1UL << 21)   /* one huge page */
+
+/* 1------------------1 */
+
+/* Allocate bytes for a table.  *zeroed is set if the */
+/* storage is known to be all zero bits.              */
+static void *tblalloc(size_t bytes, int *zeroed)
+{
+#ifdef hshMMAP
+   void *p;
+
+   if (bytes >= BIGTBL) {
+      p = mmap(NULL, bytes, PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (MAP_FAILED == p) return NULL;
+#  ifdef MADV_HUGEPAGE
+      (void) madvise(p, bytes, MADV_HUGEPAGE);  /* only advice */
+#  endif
+      *zeroed = 1;
+      return p;
+   }
+#endif
+   *zeroed = 0;
+   return malloc(bytes);
+} /* tblalloc */
+
+/* 1------------------1 */
+
+/* Free p, which tblalloc gave for bytes.  Accepts NULL */
+static void tblfree(void *p, size_t bytes)
+{
+#ifdef hshMMAP
+   if (p && (bytes >= BIGTBL)) {
+      munmap(p, bytes);
+      return;
+   }
+#endif
+   (void) bytes;
+   free(p);
+} /* tblfree */
+
+/* 1------------------1 */
+
+/* free tbl of size slots, unless the hshSMALL slots of master */
+static void freetbl(hshtblptr master, hshslot *tbl,
+                    unsigned long size)
+{
+   if (tbl != INLINE(master)) tblfree(tbl, size * sizeof *tbl);
+} /* freetbl */
+
+/* 1------------------1 */
+
 /* Create, allocate and initialize an empty hash table      */
 /* This is always doubling the table size, and the size of  */
 /* all the old tables together won't hold it.  So any       */
 /* freed old table space is effectively useless for this    */
 /* because of fragmentation. Changing the ratio won't help. */
-static void* *maketbl(unsigned long newsize)
+/* A mapped table is already zero, NULL on Linux.           */
+static hshslot *maketbl(unsigned long newsize)
 {
    unsigned long  i;
-   void*         *newtbl;
+   hshslot       *newtbl;
+   int            zeroed;
 
-   newtbl = malloc(newsize * sizeof *newtbl);
-   if (newtbl) {
+   newtbl = tblalloc(newsize * sizeof *newtbl, &zeroed);
+   if (newtbl && !zeroed) {
       for (i = 0; i < newsize; i++)
-         newtbl[i] = NULL;
+         newtbl[i].item = NULL;
    }
    return newtbl;
 } /* maketbl */
 
 /* 1------------------1 */
 
+#define INITSZ 17   /* small prime, for easy testing */
+
+/* The size of the smallest table holding n entries below */
+/* the threshold, 0 if there is no such size              */
+static unsigned long sizefor(unsigned long n)
+{
+   unsigned long sz;
+   size_t        i;
+
+   sz = INITSZ;
+   for (i = 0; sz && (TTHRESH(sz) <= n); i++)
+      sz = ithprime(i);
+   return sz;
+} /* sizefor */
+
+/* 1------------------1 */
+
 /* initialize and return a pointer to the data base */
 struct hshtag *hshinit(hshfn    hash, hshfn     rehash,
                        hshcmpfn cmp,
                        hshdupfn dupe, hshfreefn undupe,
                        int      hdebug)
 {
-#define INITSZ 17   /* small prime, for easy testing */
+   return hshinitopts(hash, rehash, cmp, dupe, undupe, hdebug, NULL);
+} /* hshinit */
 
-   struct hshtag *master;
+/* 1------------------1 */
+
+/* A hshSWISS table has a power of 2 size, at least SWISSMIN, */
+/* and a control byte per slot.  The top bit marks an unused  */
+/* slot, CEMPTY or CDELETED, else the byte holds 7 bits of the */
+/* mixed hash of the item.  The first GROUPSZ bytes repeat    */
+/* after the last, so a group may be loaded at any index.     */
+#define GROUPSZ  16
+#define SWISSMIN 16
+#define CEMPTY   0x80
+#define CDELETED 0xFE
+
+/* Multiplier spreading the user hash over all the bits, the */
+/* low 7 then go to the control byte, the rest to the index. */
+#if ULONG_MAX > 4294967295UL
+#  define GOLDEN   0x9e3779b97f4a7c15UL
+#  define HALFBITS 32
+#else
+#  define GOLDEN   0x9e3779b9UL
+#  define HALFBITS 16
+#endif
+
+/* 1------------------1 */
+
+/* The size of the smallest power of 2 table, for hshSWISS   */
+/* or hshROBIN, holding n entries below the threshold, 0 if  */
+/* there is no such size                                     */
+static unsigned long pow2size(unsigned long n)
+{
+   unsigned long sz;
+
+   for (sz = SWISSMIN; sz && (TTHRESH(sz) <= n); sz <<= 1)
+      if (sz > ((size_t)-1 - GROUPSZ) / 2 / sizeof(hshslot))
+         return 0;
+   return sz;
+} /* pow2size */
+
+/* 1------------------1 */
+
+/* Allocate control bytes for a table of newsize, all CEMPTY */
+static unsigned char *makectrl(unsigned long newsize)
+{
+   unsigned char *ctrl;
+   int            zeroed;
+
+   if ((ctrl = tblalloc(newsize + GROUPSZ, &zeroed)))
+      memset(ctrl, CEMPTY, newsize + GROUPSZ);
+   return ctrl;
+} /* makectrl */
 
-   if (!hash || !rehash || !cmp || !dupe || !undupe)
+/* 1------------------1 */
+
+/* Free the control bytes of a table of size, or NULL */
+static void freectrl(unsigned char *ctrl, unsigned long size)
+{
+   tblfree(ctrl, size + GROUPSZ);
+} /* freectrl */
+
+/* 1------------------1 */
+
+/* initialize with options. NULL opts is the same as hshinit */
+struct hshtag *hshinitopts(hshfn    hash, hshfn     rehash,
+                           hshcmpfn cmp,
+                           hshdupfn dupe, hshfreefn undupe,
+                           int      hdebug,
+                           const hshopts *opts)
+{
+   struct hshtag *master;
+   unsigned long  size, i;
+   int            small;
+
+   small = opts && (opts->mode & hshSMALL)
+                && (opts->reserve <= SMALLMAX);
+   if (opts && (opts->mode & (hshSWISS | hshROBIN)))
+      size = pow2size(opts->reserve);
+   else if (opts && opts->reserve) size = sizefor(opts->reserve);
+   else size = INITSZ;
+   if (!hash || !rehash || !cmp || !size)
+      master = NULL;
+   else if (opts && (((opts->mode & hshSWISS) != 0)
+                     + ((opts->mode & hshROBIN) != 0)
+                     + ((opts->mode & hshINCREMENTAL) != 0) > 1))
+      master = NULL;  /* at most one of these */
+   else if ((opts && (opts->mode & hshARENA)) ? !opts->adupe
+                                              : (!dupe || !undupe))
       master = NULL;
-   else if ((master = malloc(sizeof *master))) {
-      if ((master->htbl = maketbl(INITSZ))) {
-         master->currentsz = INITSZ;
+   else if ((master = malloc(sizeof *master
+                             + (small ? SMALLMAX * sizeof(hshslot)
+                                        + GROUPSZ
+                                      : 0)))) {
+      master->ctrl = NULL;
+      if (small) {
+         master->htbl = INLINE(master);
+         for (i = 0; i < SMALLMAX; i++) master->htbl[i].item = NULL;
+         memset(INLINETAGS(master), 0, GROUPSZ);
+         size = SMALLMAX;
+      }
+      else if ((opts && (opts->mode & hshSWISS))
+               && !(master->ctrl = makectrl(size)))
+         master->htbl = NULL;
+      else master->htbl = maketbl(size);
+      if (master->htbl) {
+         master->currentsz = size;
          master->hash = hash; master->rehash = rehash;
          master->cmp = cmp;
          master->dupe = dupe; master->undupe = undupe;
          master->hdebug = hdebug;
+         master->mode = opts ? opts->mode : hshDEFAULT;
+         if (!small) master->mode &= ~hshSMALL;
+         master->oldtbl = NULL;
+         master->oldsz = master->oldnext = 0;
+         master->adupe = (master->mode & hshARENA) ? opts->adupe
+                                                   : NULL;
+         master->arena = NULL;
 
          /* initialise the status portion */
          master->hstatus.probes = master->hstatus.misses = 0;
@@ -172,12 +479,13 @@ struct hshtag *hshinit(hshfn    hash, hshfn     rehash,
          master->hstatus.version = VER;
       }
       else {
+         freectrl(master->ctrl, size);
          free(master);
          master = NULL;
       }
    }
    return master;
-} /* hshinit */
+} /* hshinitopts */
 
 /* 1------------------1 */
 
@@ -186,46 +494,111 @@ void hshkill(hshtblptr master)
 {
    unsigned long i;
    void         *h;                                    /*v7*/
+   hshslab      *slab;
 
    /* unload the actual data storage */
-   if (master) {
+   if (master && (master->mode & hshARENA)) {
+      /* the items are all in the arena, freed below */
+      freetbl(master, master->htbl, master->currentsz);
+      freetbl(master, master->oldtbl, master->oldsz);
+   }
+   else if (master) {
       for (i = 0; i < master->currentsz; i++) {
-         if ((h = master->htbl[i]) && (DELETED != h))  /*v7*/
-            master->undupe(master->htbl[i]);
+         if ((h = master->htbl[i].item) && (DELETED != h))  /*v7*/
+            master->undupe(h);
+      }
+      freetbl(master, master->htbl, master->currentsz);  /* v1001 */
+      if (master->oldtbl) {              /* mid migration */
+         for (i = 0; i < master->oldsz; i++) {
+            if ((h = master->oldtbl[i].item) && (DELETED != h))
+               master->undupe(h);
+         }
+         freetbl(master, master->oldtbl, master->oldsz);
+      }
+   }
+   if (master) {
+      while ((slab = master->arena)) {
+         master->arena = slab->next;
+         free(slab);
       }
-      free(master->htbl);                         /* v1001 */
+      freectrl(master->ctrl, master->currentsz);
    }
    free(master);
 } /* hshkill */
 
 /* 1------------------1 */
 
-/* Attempt to insert item at the hth position in the table */
-/* Returns NULL if position already taken or if dupe fails */
-/* (when master->herror is set to hshNOMEM)                */
+/* Allocate size bytes that live until hshkill(master), */
+/* from the slabs of the table.  NULL if out of memory  */
+void * hshaalloc(hshtblptr master, size_t size)
+{
+   hshslab *slab;
+   size_t   want;
+   void    *p;
+
+   if (size > (size_t)-1 - SLABHDR - ALIGNSZ) return NULL;
+   size = ROUNDUP(size ? size : 1);
+   slab = master->arena;
+   if (!slab || (slab->size - slab->used < size)) {
+      want = (size > SLABSZ / 4) ? size : SLABSZ;
+      if (!(slab = malloc(SLABHDR + want))) return NULL;
+      slab->size = want;
+      slab->used = 0;
+      if ((want == size) && master->arena) {
+         /* a big one, keep filling the current slab */
+         slab->next = master->arena->next;
+         master->arena->next = slab;
+      }
+      else {
+         slab->next = master->arena;
+         master->arena = slab;
+      }
+   }
+   p = (char *)slab + SLABHDR + slab->used;
+   slab->used += size;
+   return p;
+} /* hshaalloc */
+
+/* 1------------------1 */
+
+/* Attempt to insert entry at the hth position in the table */
+/* Returns NULL if position already taken or if dupe fails  */
+/* (when master->herror is set to hshNOMEM).  *rehashed is  */
+/* non-zero once entry->rehash is valid.  A new item needs  */
+/* it stored, so it is found here if the first probe hit.   */
 static void * inserted(hshtblptr master, unsigned long h,
-                       void *item,
+                       hshslot *entry, int *rehashed,
                        int copying)  /* during reorganization */
 {
-   void  * hh;
+   hshslot *hh;
 
    master->hstatus.probes++;         /* count total probes */
-   hh = master->htbl[h];
-   if (NULL == hh) {                  /* we have found a slot */
-      if (copying) master->htbl[h] = item;
-      else if ((master->htbl[h] = master->dupe(item)))
+   hh = &master->htbl[h];
+   if (NULL == hh->item) {            /* we have found a slot */
+      if (!*rehashed) {
+         entry->rehash = master->rehash(entry->item);
+         *rehashed = 1;
+      }
+      if (copying) *hh = *entry;
+      else if ((hh->item = master->adupe
+                           ? master->adupe(entry->item, master)
+                           : master->dupe(entry->item))) {
          /* new entry, so dupe and insert */
+         hh->hash = entry->hash;
+         hh->rehash = entry->rehash;
          master->hstatus.hentries++;          /* count 'em */
+      }
       else master->hstatus.herror |= hshNOMEM;
    }
    else if (copying) return NULL; /* no compare if copying */
-   else if (DELETED == hh) return NULL;  /* nor if DELETED */
-   else if (0 != master->cmp(master->htbl[h], item)) {
+   else if (DELETED == hh->item) return NULL; /* nor if DELETED */
+   else if ((hh->hash != entry->hash)
+            || (0 != master->cmp(hh->item, entry->item))) {
       /* not found here */
       return NULL;
    }
 /* else found already inserted here */
-   return master->htbl[h];
+   return hh->item;
 } /* inserted */
 
 /* 1------------------1 */
@@ -233,19 +606,28 @@ static void * inserted(hshtblptr master, unsigned long h,
 /* insert an entry.  NULL == failure, else item */
 /* This always succeeds unless memory runs out, */
 /* provided that the hashtable is not full      */
-static void * putintbl(hshtblptr master, void *item, int copying)
+/* entry->hash must be set, and entry->rehash   */
+/* too if rehashed. When copying the whole slot */
+/* is moved and no hash is called.              */
+static void * putintbl(hshtblptr master, hshslot *entry,
+                       int rehashed, int copying)
 {
    unsigned long h, h2;
    void         *stored;
 
-   h = master->hash(item) % master->currentsz;
-   if (!(stored = inserted(master, h, item, copying))
+   if (copying) rehashed = 1;
+   h = entry->hash % master->currentsz;
+   if (!(stored = inserted(master, h, entry, &rehashed, copying))
        && master->hstatus.herror == hshOK) {
-      h2 = master->rehash(item) % (master->currentsz >> 3) + 1;
+      if (!rehashed) {
+         entry->rehash = master->rehash(entry->item);
+         rehashed = 1;
+      }
+      h2 = entry->rehash % (master->currentsz >> 3) + 1;
       do {       /* we had to go past 1 per item */
          master->hstatus.misses++;
          h = (h + h2) % master->currentsz;
-      } while (!(stored = inserted(master, h, item, copying))
+      } while (!(stored = inserted(master, h, entry, &rehashed, copying))
                && (master->hstatus.herror == hshOK));
    }
    return stored;
@@ -253,22 +635,13 @@ static void * putintbl(hshtblptr master, void *item, int copying)
 
 /* 1------------------1 */
 
-/* Increase the table size by roughly a factor of 2    */
-/* reinsert all entries from the old table in the new. */
-/* revise the currentsz value to match                 */
-/* free the storage for the old table.                 */
-static int reorganize(hshtblptr master)
+/* The size the table should be reorganized to, 0 if none */
+static unsigned long nextsize(hshtblptr master)
 {
-   void*         *newtbl;
-   void*         *oldtbl;
    unsigned long  newsize, oldsize;
-   unsigned long  oldentries, j;
    unsigned int   i;
 
    oldsize = master->currentsz;
-   oldtbl =  master->htbl;
-   oldentries = 0;
-
    if (master->hstatus.hdeleted > (master->hstatus.hentries / 4))
       /* don't expand table if we can get reasonable space  */
       /* by simply removing the accumulated DELETED entries */
@@ -278,6 +651,26 @@ static int reorganize(hshtblptr master)
       for (i = 1; newsize && (newsize <= oldsize); i++)
          newsize = ithprime(i);
    }
+   return newsize;
+} /* nextsize */
+
+/* 1------------------1 */
+
+/* Change the table size to newsize, 0 meaning failure */
+/* reinsert all entries from the old table in the new. */
+/* revise the currentsz value to match                 */
+/* free the storage for the old table.                 */
+static int resize(hshtblptr master, unsigned long newsize)
+{
+   hshslot       *newtbl;
+   hshslot       *oldtbl;
+   unsigned long  oldsize;
+   unsigned long  oldentries, j;
+
+   oldsize = master->currentsz;
+   oldtbl =  master->htbl;
+   oldentries = 0;
+
    if (newsize) newtbl = maketbl(newsize);
    else         newtbl = NULL;
 
@@ -287,15 +680,15 @@ static int reorganize(hshtblptr master)
 
       /* Now reinsert all old entries in new table */
       for (j = 0; j < oldsize; j++)
-         if (oldtbl[j] && (oldtbl[j] != DELETED)) {
-            (void) putintbl(master, oldtbl[j], 1);
+         if (oldtbl[j].item && (oldtbl[j].item != DELETED)) {
+            (void) putintbl(master, &oldtbl[j], 1, 1);
             oldentries++;
          }
       /* Sanity check */
       if (oldentries != master->hstatus.hentries
                         - master->hstatus.hdeleted) {
          master->hstatus.herror |= hshINTERR;
-         free(master->htbl);
+         freetbl(master, master->htbl, master->currentsz);
          master->htbl = oldtbl;
          master->currentsz = oldsize;
          return 0;      /* failure */
@@ -303,75 +696,861 @@ static int reorganize(hshtblptr master)
       else {
          master->hstatus.hentries = oldentries;
          master->hstatus.hdeleted = 0;
-         free(oldtbl);
+         freetbl(master, oldtbl, oldsize);
          return 1;      /* success */
       }
    }
    return 0;            /* failure */
-} /* reorganize */
+} /* resize */
 
 /* 1------------------1 */
 
-/* insert an entry.  NULL == failure, else item */
-void * hshinsert(hshtblptr master, void *item)
+/* Increase the table size by roughly a factor of 2 */
+static int reorganize(hshtblptr master)
 {
-   if ((TSPACE(master) <= 0) && !reorganize(master)) {
-      master->hstatus.herror |= hshTBLFULL;
-      return NULL;
-   }
-   return putintbl(master, item, 0);
-} /* hshinsert */
+   return resize(master, nextsize(master));
+} /* reorganize */
 
 /* 1------------------1 */
 
-/* Attempt to find item at the hth position in the table */
-/* counting attempts.  Returns 1 if found, else 0        */
-static int found(hshtblptr master, unsigned long h, void *item)
+/* Attempt to find key->item at the hth position of tbl  */
+/* counting attempts in st.  Returns 1 if found, else 0. */
+/* cmp is only called when the stored hash matches,      */
+/* which is nearly always a true match.                  */
+static int found(const struct hshtag *master,
+                 hshslot *tbl, unsigned long h,
+                 hshslot *key, hshstats *st)
 {
-   void *hh;
+   hshslot *hh;
 
-   master->hstatus.probes++;            /* count total probes */
-   hh = master->htbl[h];
-   if ((hh) && (hh != DELETED))  /* NEVER cmp against DELETED */
-      return !(master->cmp(hh, item));
+   st->probes++;                        /* count total probes */
+   hh = &tbl[h];
+   if ((hh->item) && (hh->item != DELETED)  /* NEVER cmp DELETED */
+       && (hh->hash == key->hash))
+      return !(master->cmp(hh->item, key->item));
    else return 0;
 } /* found */
 
 /* 1------------------1 */
 
-/* Find the current hashtbl index for item, or an empty slot */
-static unsigned long huntup(hshtblptr master, void *item)
+/* Find the index in tbl, of size sz, for key->item, or */
+/* of an empty slot.  key->hash must be set. rehash is  */
+/* called once into key->rehash, and *rehashed set, if  */
+/* the first probe misses and *rehashed is still 0.     */
+/* Probes and misses are counted in st, the table is    */
+/* never written.                                       */
+static unsigned long huntup(const struct hshtag *master,
+                            hshslot *tbl, unsigned long sz,
+                            hshslot *key, int *rehashed,
+                            hshstats *st)
 {
    unsigned long h, h2;
 
-   h = master->hash(item) % master->currentsz;
+   h = key->hash % sz;
 
    /* Within this a DELETED item simply causes a rehash */
    /* i.e. treat it like a non-equal item               */
 
-   if (!(found(master, h, item)) && master->htbl[h]) {
-      h2 = master->rehash(item) % (master->currentsz >> 3) + 1;
+   if (!(found(master, tbl, h, key, st)) && tbl[h].item) {
+      if (!*rehashed) {
+         key->rehash = master->rehash(key->item);
+         *rehashed = 1;
+      }
+      h2 = key->rehash % (sz >> 3) + 1;
       do {       /* we had to go past 1 per item */
-         master->hstatus.misses++;
-         h = (h + h2) % master->currentsz;
-      } while (!(found(master, h, item)) && (master->htbl[h]));
+         st->misses++;
+         h = (h + h2) % sz;
+      } while (!(found(master, tbl, h, key, st)) && (tbl[h].item));
    }
    return h;
 } /* huntup */
 
 /* 1------------------1 */
 
+/* ============= The hshSWISS engine ============= */
+
+/* The hash of an item mixed, for the control byte and index */
+static unsigned long swissmix(unsigned long hash)
+{
+   hash *= GOLDEN;
+   return hash ^ (hash >> HALFBITS);
+} /* swissmix */
+
+/* 1------------------1 */
+
+/* Bit i of the result is set when g[i] == c, i < GROUPSZ */
+static unsigned int groupmatch(const unsigned char *g, unsigned int c)
+{
+#ifdef __SSE2__
+   return (unsigned int)_mm_movemask_epi8(
+             _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)g),
+                            _mm_set1_epi8((char)c)));
+#else
+   unsigned int i, m;
+
+   for (m = i = 0; i < GROUPSZ; i++)
+      if (g[i] == c) m |= 1U << i;
+   return m;
+#endif
+} /* groupmatch */
+
+/* 1------------------1 */
+
+/* Bit i of the result is set when g[i] is CEMPTY or CDELETED */
+static unsigned int groupunused(const unsigned char *g)
+{
+#ifdef __SSE2__
+   return (unsigned int)_mm_movemask_epi8(
+             _mm_loadu_si128((const __m128i *)g));
+#else
+   unsigned int i, m;
+
+   for (m = i = 0; i < GROUPSZ; i++)
+      if (g[i] & 0x80) m |= 1U << i;
+   return m;
+#endif
+} /* groupunused */
+
+/* 1------------------1 */
+
+/* The index of the lowest set bit of m, which is not 0 */
+static unsigned int lowbit(unsigned int m)
+{
+#ifdef __GNUC__
+   return (unsigned int)__builtin_ctz(m);
+#else
+   unsigned int i;
+
+   for (i = 0; !(m & 1); m >>= 1) i++;
+   return i;
+#endif
+} /* lowbit */
+
+/* 1------------------1 */
+
+/* Set control byte i, and its copy beyond the end */
+static void setctrl(hshtblptr master, unsigned long i, unsigned int c)
+{
+   master->ctrl[i] = (unsigned char)c;
+   if (i < GROUPSZ) master->ctrl[master->currentsz + i] = (unsigned char)c;
+} /* setctrl */
+
+/* 1------------------1 */
+
+/* Find the index of key->item, or currentsz when absent.   */
+/* key->hash must be set.  Each group examined is a probe,  */
+/* each step to another group a miss.  The groups are taken */
+/* at triangular number multiples of GROUPSZ on, which in a */
+/* power of 2 table reaches every slot, and the threshold   */
+/* ensures a group with a CEMPTY byte ends the search.      */
+static unsigned long swisshunt(const struct hshtag *master,
+                               hshslot *key, hshstats *st)
+{
+   unsigned long        mask, mix, pos, stride, i;
+   unsigned int         m;
+   const unsigned char *g;
+
+   mask = master->currentsz - 1;
+   mix = swissmix(key->hash);
+   pos = (mix >> 7) & mask;
+   for (stride = 0; ; pos = (pos + stride) & mask) {
+      st->probes++;
+      g = master->ctrl + pos;
+      for (m = groupmatch(g, mix & 0x7f); m; m &= m - 1) {
+         i = (pos + lowbit(m)) & mask;
+         if ((master->htbl[i].hash == key->hash)
+             && !master->cmp(master->htbl[i].item, key->item))
+            return i;
+      }
+      if (groupmatch(g, CEMPTY)) return master->currentsz;
+      st->misses++;
+      stride += GROUPSZ;
+   }
+} /* swisshunt */
+
+/* 1------------------1 */
+
+/* Put entry in the first unused slot of its probe sequence */
+/* It must not be present.  When copying the whole slot is  */
+/* moved, else the item is duped.  NULL on dupe failure.    */
+static void * swissput(hshtblptr master, hshslot *entry, int copying)
+{
+   unsigned long        mask, mix, pos, stride, i;
+   unsigned int         m;
+
+   mask = master->currentsz - 1;
+   mix = swissmix(entry->hash);
+   pos = (mix >> 7) & mask;
+   for (stride = 0; !(m = groupunused(master->ctrl + pos));
+        pos = (pos + stride) & mask)
+      stride += GROUPSZ;
+   i = (pos + lowbit(m)) & mask;
+   if (copying) master->htbl[i] = *entry;
+   else if ((master->htbl[i].item = master->adupe
+                        ? master->adupe(entry->item, master)
+                        : master->dupe(entry->item)))
+      master->htbl[i].hash = entry->hash;
+   else {
+      master->htbl[i].item = NULL;
+      master->hstatus.herror |= hshNOMEM;
+      return NULL;
+   }
+   if (CDELETED == master->ctrl[i]) master->hstatus.hdeleted--;
+   else                             master->hstatus.hentries++;
+   setctrl(master, i, mix & 0x7f);
+   return master->htbl[i].item;
+} /* swissput */
+
+/* 1------------------1 */
+
+/* Rebuild the hshSWISS table at newsize, 0 meaning failure */
+/* No hash function is called, the slots hold the hashes.   */
+static int swissresize(hshtblptr master, unsigned long newsize)
+{
+   hshslot       *oldtbl;
+   unsigned char *oldctrl;
+   unsigned long  oldsize, oldentries, j;
+
+   oldsize = master->currentsz;
+   oldtbl = master->htbl;
+   oldctrl = master->ctrl;
+   oldentries = master->hstatus.hentries - master->hstatus.hdeleted;
+   if (!newsize || !(master->ctrl = makectrl(newsize))) {
+      master->ctrl = oldctrl;
+      return 0;            /* failure */
+   }
+   if (!(master->htbl = maketbl(newsize))) {
+      freectrl(master->ctrl, newsize);
+      master->ctrl = oldctrl;
+      master->htbl = oldtbl;
+      return 0;            /* failure */
+   }
+   master->currentsz = newsize;
+   master->hstatus.hentries = master->hstatus.hdeleted = 0;
+   for (j = 0; j < oldsize; j++)  /* no oldctrl if hshSMALL */
+      if (oldctrl ? !(oldctrl[j] & 0x80) : (NULL != oldtbl[j].item))
+         (void) swissput(master, &oldtbl[j], 1);
+   if (oldentries != master->hstatus.hentries)  /* Sanity check */
+      master->hstatus.herror |= hshINTERR;
+   freetbl(master, oldtbl, oldsize);
+   freectrl(oldctrl, oldsize);
+   return 1;               /* success */
+} /* swissresize */
+
+/* 1------------------1 */
+
+/* hshinsert for the hshSWISS mode.  Growth doubles the size */
+/* unless dropping the CDELETED slots makes enough room.     */
+static void * swissinsert(hshtblptr master, void *item)
+{
+   hshslot       entry;
+   unsigned long i, newsize;
+
+   entry.item = item;
+   entry.hash = master->hash(item);
+   i = swisshunt(master, &entry, &master->hstatus);
+   if (i < master->currentsz) return master->htbl[i].item;
+   if (TSPACE(master) <= 0) {
+      if (master->hstatus.hdeleted > (master->hstatus.hentries / 4))
+         newsize = master->currentsz;
+      else newsize = pow2size(master->currentsz);
+      if (!swissresize(master, newsize)) {
+         master->hstatus.herror |= hshTBLFULL;
+         return NULL;
+      }
+   }
+   return swissput(master, &entry, 0);
+} /* swissinsert */
+
+/* ============= End of the hshSWISS engine ============= */
+
+/* ============= The hshROBIN engine ============= */
+
+/* A hshROBIN table has a power of 2 size and is probed one */
+/* slot after another from the home index of the hash.  An */
+/* insertion takes the slot of any item nearer its home     */
+/* than the new one is, and moves that item on instead, so  */
+/* no item is ever much further from home than the rest.  A */
+/* search stops at the first item nearer its home than the  */
+/* search has come.  A deletion moves the following items   */
+/* back one slot, until one already home or an empty slot,  */
+/* which leaves no DELETED slots to step over later.        */
+
+/* The home index of hash */
+static unsigned long robinhome(const struct hshtag *master,
+                               unsigned long hash)
+{
+   return swissmix(hash) & (master->currentsz - 1);
+} /* robinhome */
+
+/* 1------------------1 */
+
+/* Find the index of key->item, or currentsz when absent.  */
+/* key->hash must be set.  Each slot looked at is a probe. */
+static unsigned long robinhunt(const struct hshtag *master,
+                               hshslot *key, hshstats *st)
+{
+   unsigned long  mask, i, d;
+   hshslot       *hh;
+
+   mask = master->currentsz - 1;
+   i = robinhome(master, key->hash);
+   for (d = 0; ; d++, i = (i + 1) & mask) {
+      st->probes++;
+      hh = &master->htbl[i];
+      if (!hh->item
+          || (((i - robinhome(master, hh->hash)) & mask) < d))
+         return master->currentsz;
+      if ((hh->hash == key->hash) && !master->cmp(hh->item, key->item))
+         return i;
+      st->misses++;
+   }
+} /* robinhunt */
+
+/* 1------------------1 */
+
+/* Put entry, which must not be present, in the table.  When */
+/* copying the whole slot is moved, else the item is duped.  */
+/* Returns the stored item, NULL on dupe failure.            */
+static void * robinput(hshtblptr master, hshslot *entry, int copying)
+{
+   unsigned long  mask, i, d, e;
+   hshslot        cur, tmp, *hh;
+
+   if (copying) cur = *entry;
+   else if ((cur.item = master->adupe
+                        ? master->adupe(entry->item, master)
+                        : master->dupe(entry->item)))
+      cur.hash = entry->hash;
+   else {
+      master->hstatus.herror |= hshNOMEM;
+      return NULL;
+   }
+   entry = NULL;
+   mask = master->currentsz - 1;
+   i = robinhome(master, cur.hash);
+   for (d = 0; ; d++, i = (i + 1) & mask) {
+      hh = &master->htbl[i];
+      if (!hh->item) break;
+      if ((e = (i - robinhome(master, hh->hash)) & mask) < d) {
+         /* the new one is further from home, swap */
+         tmp = *hh; *hh = cur; cur = tmp;
+         if (!entry) entry = hh;
+         d = e;
+      }
+   }
+   *hh = cur;
+   if (!entry) entry = hh;
+   master->hstatus.hentries++;
+   return entry->item;
+} /* robinput */
+
+/* 1------------------1 */
+
+/* Rebuild the hshROBIN table at newsize, 0 meaning failure */
+static int robinresize(hshtblptr master, unsigned long newsize)
+{
+   hshslot       *oldtbl;
+   unsigned long  oldsize, oldentries, j;
+
+   oldsize = master->currentsz;
+   oldtbl = master->htbl;
+   oldentries = master->hstatus.hentries;
+   if (!newsize || !(master->htbl = maketbl(newsize))) {
+      master->htbl = oldtbl;
+      return 0;            /* failure */
+   }
+   master->currentsz = newsize;
+   master->hstatus.hentries = 0;
+   for (j = 0; j < oldsize; j++)
+      if (oldtbl[j].item) (void) robinput(master, &oldtbl[j], 1);
+   if (oldentries != master->hstatus.hentries)  /* Sanity check */
+      master->hstatus.herror |= hshINTERR;
+   freetbl(master, oldtbl, oldsize);
+   return 1;               /* success */
+} /* robinresize */
+
+/* 1------------------1 */
+
+/* hshinsert for the hshROBIN mode, doubling the size as needed */
+static void * robininsert(hshtblptr master, void *item)
+{
+   hshslot       entry;
+   unsigned long i;
+
+   entry.item = item;
+   entry.hash = master->hash(item);
+   i = robinhunt(master, &entry, &master->hstatus);
+   if (i < master->currentsz) return master->htbl[i].item;
+   if ((TSPACE(master) <= 0)
+       && !robinresize(master, pow2size(master->currentsz))) {
+      master->hstatus.herror |= hshTBLFULL;
+      return NULL;
+   }
+   return robinput(master, &entry, 0);
+} /* robininsert */
+
+/* 1------------------1 */
+
+/* hshdelete for the hshROBIN mode */
+static void * robindelete(hshtblptr master, void *item)
+{
+   hshslot        key;
+   unsigned long  mask, i, j;
+   void          *olditem;
+
+   key.item = item;
+   key.hash = master->hash(item);
+   i = robinhunt(master, &key, &master->hstatus);
+   if (i == master->currentsz) return NULL;
+   olditem = master->htbl[i].item;
+   mask = master->currentsz - 1;
+   for (j = (i + 1) & mask;
+        master->htbl[j].item
+        && (j != robinhome(master, master->htbl[j].hash));
+        j = (j + 1) & mask) {
+      master->htbl[i] = master->htbl[j];    /* back one */
+      i = j;
+   }
+   master->htbl[i].item = NULL;
+   master->hstatus.hentries--;
+   return olditem;
+} /* robindelete */
+
+/* ============= End of the hshROBIN engine ============= */
+
+/* ============= The hshSMALL layout ============= */
+
+/* The items of a hshSMALL table fill htbl[0..hentries-1] */
+/* There are no DELETED slots, and neither the hash nor   */
+/* the table size limits a search.  Slot i has the tag    */
+/* byte INLINETAGS(master)[i], and a search matches all   */
+/* the tags at once, as hshSWISS does a group of control  */
+/* bytes, looking at a slot only where its tag is equal.  */
+
+/* The tag byte of an item of hash */
+static unsigned int smalltag(unsigned long hash)
+{
+   return (unsigned int)(swissmix(hash) & 0xff);
+} /* smalltag */
+
+/* 1------------------1 */
+
+/* The index of key->item, or currentsz when absent.  */
+/* key->hash must be set.  A search counts one probe. */
+static unsigned long smallhunt(const struct hshtag *master,
+                               hshslot *key, hshstats *st)
+{
+   unsigned long  i, n, hash;
+   unsigned int   m, tag;
+   hshslot       *tbl;
+   unsigned char *tags;
+
+   st->probes++;
+   tbl = master->htbl;
+   tags = INLINETAGS(master);
+   n = master->hstatus.hentries;
+   hash = key->hash;
+   tag = smalltag(hash);
+   for (m = groupmatch(tags, tag) & ((1U << n) - 1); m; m &= m - 1) {
+      i = lowbit(m);
+      if ((tbl[i].hash == hash) && !master->cmp(tbl[i].item, key->item))
+         return i;
+   }
+   return master->currentsz;
+} /* smallhunt */
+
+/* 1------------------1 */
+
+/* Move the items of a hshSMALL table into a hashed table, */
+/* of the layout of the other modes, sized for n entries.  */
+/* 0 on failure, when the table stays as it was.           */
+static int promote(hshtblptr master, unsigned long n)
+{
+   unsigned long i;
+   int           ok;
+
+   master->mode &= ~hshSMALL;
+   if (master->mode & hshSWISS)
+      ok = swissresize(master, pow2size(n));
+   else if (master->mode & hshROBIN)
+      ok = robinresize(master, pow2size(n));
+   else {  /* double hashing, resize needs the rehashes */
+      for (i = 0; i < master->hstatus.hentries; i++)
+         master->htbl[i].rehash = master->rehash(master->htbl[i].item);
+      ok = resize(master, sizefor(n));
+   }
+   if (!ok) master->mode |= hshSMALL;
+   return ok;
+} /* promote */
+
+/* 1------------------1 */
+
+/* hshinsert for the hshSMALL mode, promoting when full */
+static void * smallinsert(hshtblptr master, void *item)
+{
+   hshslot       entry, *hh;
+   unsigned long i;
+
+   entry.item = item;
+   entry.hash = master->hash(item);
+   i = smallhunt(master, &entry, &master->hstatus);
+   if (i < master->currentsz) return master->htbl[i].item;
+   if (SMALLMAX == master->hstatus.hentries) {
+      if (!promote(master, SMALLMAX + 1)) {
+         master->hstatus.herror |= hshTBLFULL;
+         return NULL;
+      }
+      return hshinsert(master, item);
+   }
+   hh = &master->htbl[master->hstatus.hentries];
+   if ((hh->item = master->adupe ? master->adupe(item, master)
+                                 : master->dupe(item))) {
+      hh->hash = entry.hash;
+      INLINETAGS(master)[master->hstatus.hentries] =
+         (unsigned char)smalltag(entry.hash);
+      master->hstatus.hentries++;
+   }
+   else master->hstatus.herror |= hshNOMEM;
+   return hh->item;
+} /* smallinsert */
+
+/* 1------------------1 */
+
+/* hshdelete for the hshSMALL mode.  The last item fills */
+/* the gap, so the items stay together.                  */
+static void * smalldelete(hshtblptr master, void *item)
+{
+   hshslot        key;
+   unsigned long  i, last;
+   void          *olditem;
+
+   key.item = item;
+   key.hash = master->hash(item);
+   i = smallhunt(master, &key, &master->hstatus);
+   if (i == master->currentsz) return NULL;
+   olditem = master->htbl[i].item;
+   last = --master->hstatus.hentries;
+   master->htbl[i] = master->htbl[last];
+   INLINETAGS(master)[i] = INLINETAGS(master)[last];
+   master->htbl[last].item = NULL;
+   return olditem;
+} /* smalldelete */
+
+/* ============= End of the hshSMALL layout ============= */
+
+/* 1------------------1 */
+
+/* Find the slot holding key->item in either table, or */
+/* NULL, counting probes and misses in st.  key->hash   */
+/* must be set.                                         */
+static hshslot *locatekey(const struct hshtag *master, hshslot *key,
+                          hshstats *st)
+{
+   unsigned long h;
+   int           rehashed;
+
+   if (master->mode & hshSMALL) {
+      h = smallhunt(master, key, st);
+      return (h < master->currentsz) ? &master->htbl[h] : NULL;
+   }
+   if (master->ctrl) {   /* hshSWISS */
+      h = swisshunt(master, key, st);
+      return (h < master->currentsz) ? &master->htbl[h] : NULL;
+   }
+   if (master->mode & hshROBIN) {
+      h = robinhunt(master, key, st);
+      return (h < master->currentsz) ? &master->htbl[h] : NULL;
+   }
+   rehashed = 0;
+   h = huntup(master, master->htbl, master->currentsz,
+              key, &rehashed, st);
+   if (master->htbl[h].item) return &master->htbl[h];
+   if (master->oldtbl) {
+      h = huntup(master, master->oldtbl, master->oldsz,
+                 key, &rehashed, st);
+      if (master->oldtbl[h].item) return &master->oldtbl[h];
+   }
+   return NULL;
+} /* locatekey */
+
+/* 1------------------1 */
+
+/* Find the slot holding item in either table, or NULL */
+/* counting probes and misses in st                    */
+static hshslot *locate(const struct hshtag *master, void *item,
+                       hshstats *st)
+{
+   hshslot key;
+
+   key.item = item;
+   key.hash = master->hash(item);
+   return locatekey(master, &key, st);
+} /* locate */
+
+/* 1------------------1 */
+
+/* Set key->hash and start fetching the first slot a search */
+/* for it will look at, and for hshSWISS its control bytes,  */
+/* into the cache.  A hshSMALL table is searched in place.   */
+static void prefetchhome(const struct hshtag *master, hshslot *key)
+{
+   unsigned long i;
+
+   key->hash = master->hash(key->item);
+   if (master->mode & hshSMALL) return;
+   if (master->ctrl) {
+      i = (swissmix(key->hash) >> 7) & (master->currentsz - 1);
+      PREFETCH(master->ctrl + i);
+   }
+   else if (master->mode & hshROBIN) i = robinhome(master, key->hash);
+   else i = key->hash % master->currentsz;
+   PREFETCH(&master->htbl[i]);
+} /* prefetchhome */
+
+/* 1------------------1 */
+
+/* Once the slots from prefetchhome have arrived, the item   */
+/* in the first one holding a hash equal to hash, which cmp  */
+/* will read, else NULL.  The caller prefetches it, since    */
+/* gcc may drop a function that does nothing but prefetch.   */
+static void *candidate(const struct hshtag *master, unsigned long hash)
+{
+   unsigned long  mix, i;
+   unsigned int   m;
+   hshslot       *hh;
+
+   if (master->mode & hshSMALL) return NULL;
+   if (master->ctrl) {
+      mix = swissmix(hash);
+      i = (mix >> 7) & (master->currentsz - 1);
+      if (!(m = groupmatch(master->ctrl + i, mix & 0x7f))) return NULL;
+      hh = &master->htbl[(i + lowbit(m)) & (master->currentsz - 1)];
+   }
+   else if (master->mode & hshROBIN)
+      hh = &master->htbl[robinhome(master, hash)];
+   else hh = &master->htbl[hash % master->currentsz];
+   if (hh->item && (hh->item != DELETED) && (hh->hash == hash))
+      return hh->item;
+   return NULL;
+} /* candidate */
+
+/* 1------------------1 */
+
+/* Begin an incremental reorganization.  The current    */
+/* table becomes oldtbl, to be emptied into a new table */
+/* a few slots per insertion by migrate().  Accumulated */
+/* DELETED entries are dropped from the counts at once. */
+static int startmigration(hshtblptr master)
+{
+   hshslot       *newtbl;
+   unsigned long  newsize;
+
+   if ((newsize = nextsize(master)) && (newtbl = maketbl(newsize))) {
+      master->oldtbl = master->htbl;
+      master->oldsz = master->currentsz;
+      master->oldnext = 0;
+      master->htbl = newtbl;
+      master->currentsz = newsize;
+      master->hstatus.hentries -= master->hstatus.hdeleted;
+      master->hstatus.hdeleted = 0;
+      return 1;      /* success */
+   }
+   return 0;         /* failure */
+} /* startmigration */
+
+/* 1------------------1 */
+
+/* Move up to count slots of oldtbl into htbl.  A moved  */
+/* slot is marked DELETED so that probe chains through   */
+/* it still reach the items remaining.  The counts need  */
+/* no change.  oldtbl is freed once it has been emptied. */
+static void migrate(hshtblptr master, unsigned long count)
+{
+   hshslot *old;
+
+   while (count-- && (master->oldnext < master->oldsz)) {
+      old = &master->oldtbl[master->oldnext++];
+      if (old->item && (old->item != DELETED)) {
+         (void) putintbl(master, old, 1, 1);
+         old->item = DELETED;
+      }
+   }
+   if (master->oldnext >= master->oldsz) {
+      freetbl(master, master->oldtbl, master->oldsz);
+      master->oldtbl = NULL;
+   }
+} /* migrate */
+
+/* 1------------------1 */
+
+/* insert an entry.  NULL == failure, else item */
+/* In the hshINCREMENTAL mode an insertion also */
+/* moves MIGRATESTEP slots of an earlier table  */
+/* and starts, rather than does, reorganizing.  */
+void * hshinsert(hshtblptr master, void *item)
+{
+   hshslot       entry;
+   unsigned long h;
+   int           rehashed;
+
+   if (master->mode & hshSMALL) return smallinsert(master, item);
+   if (master->ctrl) return swissinsert(master, item);
+   if (master->mode & hshROBIN) return robininsert(master, item);
+   if (master->oldtbl) migrate(master, MIGRATESTEP);
+   if (TSPACE(master) <= 0) {
+      if (master->oldtbl)      /* finish the one under way */
+         migrate(master, master->oldsz);
+      if (!((master->mode & hshINCREMENTAL) ? startmigration(master)
+                                             : reorganize(master))) {
+         master->hstatus.herror |= hshTBLFULL;
+         return NULL;
+      }
+   }
+   entry.item = item;
+   entry.hash = master->hash(item);
+   rehashed = 0;
+   if (master->oldtbl) {   /* it may not have been moved yet */
+      h = huntup(master, master->oldtbl, master->oldsz,
+                 &entry, &rehashed, &master->hstatus);
+      if (master->oldtbl[h].item) return master->oldtbl[h].item;
+   }
+   return putintbl(master, &entry, rehashed, 0);
+} /* hshinsert */
+
+/* 1------------------1 */
+
+/* insert count items, each size bytes long, from the array */
+/* at items.  The table is first grown, at most once, to    */
+/* hold them all, finishing any incremental growth under    */
+/* way.  The items are then put in without any further      */
+/* threshold test, each checked against those stored as it  */
+/* goes, which with the stored hashes costs a cmp call only */
+/* for a true duplicate.  If stored is not NULL stored[i]   */
+/* receives what hshinsert would have returned for item i.  */
+/* Returns the count of items stored or found, which is     */
+/* less than count only on failure, see herror.             */
+unsigned long hshinsertmany(hshtblptr master, void *items,
+                            unsigned long count, size_t size,
+                            void **stored)
+{
+   hshslot        entry;
+   unsigned long  i, done, need;
+   char          *item;
+   void          *p;
+
+   int            full;
+
+   if (master->oldtbl) migrate(master, master->oldsz);
+   need = master->hstatus.hentries - master->hstatus.hdeleted + count;
+   if (need < count) full = 1;
+   else if (master->mode & hshSMALL)
+      full = (need > SMALLMAX) && !promote(master, need);
+   else full = (TTHRESH(master->currentsz)
+                <= master->hstatus.hentries + count)
+               && !(master->ctrl
+                    ? swissresize(master, pow2size(need))
+                    : (master->mode & hshROBIN)
+                    ? robinresize(master, pow2size(need))
+                    : resize(master, sizefor(need)));
+   if (full) {
+      master->hstatus.herror |= hshTBLFULL;
+      return 0;
+   }
+   item = items;
+   for (done = i = 0; i < count; i++, item += size) {
+      if (master->mode & hshSMALL) p = smallinsert(master, item);
+      else if (master->ctrl) p = swissinsert(master, item);
+      else if (master->mode & hshROBIN) p = robininsert(master, item);
+      else {
+         entry.item = item;
+         entry.hash = master->hash(item);
+         p = putintbl(master, &entry, 0, 0);
+      }
+      if (p) done++;
+      if (stored) stored[i] = p;
+   }
+   return done;
+} /* hshinsertmany */
+
+/* 1------------------1 */
+
 /* find an existing entry. NULL == notfound */
 void * hshfind(hshtblptr master, void *item)
 {
-   unsigned long h;
+   hshslot *slot;
 
-   h = huntup(master, item);
-   return master->htbl[h];
+   if ((slot = locate(master, item, &master->hstatus)))
+      return slot->item;
+   return NULL;
 } /* hshfind */
 
 /* 1------------------1 */
 
+/* find count items, each size bytes long, from the array at */
+/* items.  Each block of FINDBLOCK items is hashed, and the  */
+/* first slot each will probe prefetched, then the items in  */
+/* those slots, before any is searched for, so that the      */
+/* cache misses of a large table overlap instead of          */
+/* following one another.  A table of under PREFETCHMIN      */
+/* bytes of slots is just searched item by item.  If results */
+/* is not NULL results[i] receives what hshfind would have   */
+/* returned for item i.  Returns the count of items found.   */
+unsigned long hshfindmany(hshtblptr master, void *items,
+                          unsigned long count, size_t size,
+                          void **results)
+{
+   hshslot        key[FINDBLOCK], *slot;
+   unsigned long  i, j, n, hits;
+   char          *item;
+   void          *p;
+
+   item = items;
+   if (master->currentsz < PREFETCHMIN / sizeof(hshslot)) {
+      for (hits = i = 0; i < count; i++, item += size) {
+         if ((slot = locate(master, item, &master->hstatus))) hits++;
+         if (results) results[i] = slot ? slot->item : NULL;
+      }
+      return hits;
+   }
+   for (hits = i = 0; i < count; i += n) {
+      n = (count - i < FINDBLOCK) ? count - i : FINDBLOCK;
+      for (j = 0; j < n; j++, item += size) {
+         key[j].item = item;
+         prefetchhome(master, &key[j]);
+      }
+      for (j = 0; j < n; j++)
+         if ((p = candidate(master, key[j].hash))) PREFETCH(p);
+      for (j = 0; j < n; j++) {
+         if ((slot = locatekey(master, &key[j], &master->hstatus)))
+            hits++;
+         if (results) results[i + j] = slot ? slot->item : NULL;
+      }
+   }
+   return hits;
+} /* hshfindmany */
+
+/* 1------------------1 */
+
+/* find an existing entry without writing to the table.  */
+/* Probes and misses go to *stats, when not NULL, rather */
+/* than to the table statistics.  Any number of threads  */
+/* may call this at once, provided that nothing changes  */
+/* the table meanwhile and that the hash, rehash and cmp */
+/* functions are themselves safe to call concurrently.   */
+void * hshlookup(const struct hshtag *master, void *item,
+                 hshstats *stats)
+{
+   hshslot  *slot;
+   hshstats  local;
+
+   if (!stats) stats = &local;
+   if ((slot = locate(master, item, stats))) return slot->item;
+   return NULL;
+} /* hshlookup */
+
+/* 1------------------1 */
+
 /* delete an existing entry. NULL == notfound      */
 /* Disposal of the storage returned by hshdelete   */
 /* (originally created by hshdupfn) is up to the   */
@@ -379,13 +1558,22 @@ void * hshfind(hshtblptr master, void *item)
 /* It will usually be disposable by hshfreefn().   */
 void * hshdelete(hshtblptr master, void *item)
 {
-   unsigned long h;
-   void         *olditem;
-
-   h = huntup(master, item);
-   if ((olditem = master->htbl[h])) {
-      master->htbl[h] = DELETED;
-      master->hstatus.hdeleted++;
+   hshslot *slot;
+   void    *olditem;
+
+   if (master->mode & hshSMALL) return smalldelete(master, item);
+   if (master->mode & hshROBIN) return robindelete(master, item);
+   olditem = NULL;
+   if ((slot = locate(master, item, &master->hstatus))) {
+      olditem = slot->item;
+      slot->item = DELETED;
+      if (master->ctrl)   /* hshSWISS */
+         setctrl(master, slot - master->htbl, CDELETED);
+      if ((slot >= master->htbl)
+          && (slot < master->htbl + master->currentsz))
+         master->hstatus.hdeleted++;
+      else  /* in oldtbl, which is dropped when emptied */
+         master->hstatus.hentries--;
    }
    return olditem;
 } /* hshdelete */
@@ -408,16 +1596,58 @@ int    hshwalk(hshtblptr master, hshexecfn exec, void *datum)
    else                xtra = NULL;
 
    for (i = 0; i < master->currentsz; i++) {
-      hh = master->htbl[i];
+      hh = master->htbl[i].item;
       if ((hh) && (hh != DELETED))
          if ((err = exec(hh, datum, xtra)))
             return err;
    }
+   if (master->oldtbl) {      /* items not yet moved */
+      for (i = 0; i < master->oldsz; i++) {
+         hh = master->oldtbl[i].item;
+         if ((hh) && (hh != DELETED))
+            if ((err = exec(hh, datum, xtra)))
+               return err;
+      }
+   }
    return 0;
 } /* hshwalk */
 
 /* 1------------------1 */
 
+/* apply exec() to the entries in part part of parts */
+/* equal parts of the slots, counting those of the   */
+/* old table while growing as following on.  Writes  */
+/* nothing, so the parts may be walked at once.      */
+int    hshwalkrange(hshtblptr master, unsigned long part,
+                    unsigned long parts, hshexecfn exec, void *datum)
+{
+   unsigned long i, total, first, last;
+   int           err;
+   void         *xtra;
+   void         *hh;
+
+   if ((NULL == exec) || (part >= parts)) return -1;
+
+   if (master->hdebug) xtra = &i;
+   else                xtra = NULL;
+
+   total = master->currentsz;
+   if (master->oldtbl) total += master->oldsz;
+   first = total / parts * part;
+   last = (part == parts - 1) ? total : first + total / parts;
+
+   for (i = first; i < last; i++) {
+      if (i < master->currentsz) hh = master->htbl[i].item;
+      else hh = master->oldtbl[i - master->currentsz].item;
+      if ((hh) && (hh != DELETED))
+         if ((err = exec(hh, datum, xtra)))
+            return err;
+   }
+   return 0;
+} /* hshwalkrange */
+
+/* 1------------------1 */
+
 /* return various status values */
 hshstats hshstatus(hshtbl *master)
 {
@@ -457,4 +1687,78 @@ unsigned long hshstrehash(const char * string)
    return h;
 } /* hshstrehash */
 
+/* 1------------------1 */
+
+/* The word at a time hashes below are MurmurHash2 (by Austin */
+/* Appleby, public domain) in its 64 bit form, MurmurHash64A, */
+/* where unsigned long has 64 bits, else in its 32 bit form.  */
+/* Every input bit affects every output bit.  The rehash is   */
+/* the same function started from a different seed.  Words    */
+/* are read with memcpy, so keys need no alignment, and the   */
+/* values depend on the byte order of the machine.            */
+#if ULONG_MAX > 4294967295UL
+#  define MMUL   0xc6a4a7935bd1e995UL
+#  define MSHIFT 47
+#  define MFIN1  47
+#  define MFIN2  47
+#  define MSEED1 0x9e3779b97f4a7c15UL
+#  define MSEED2 0x6a09e667f3bcc909UL
+#else
+#  define MMUL   0x5bd1e995UL
+#  define MSHIFT 24
+#  define MFIN1  13
+#  define MFIN2  15
+#  define MSEED1 0x9e3779b9UL
+#  define MSEED2 0x6a09e667UL
+#endif
+
+static unsigned long memhash(const void *key, size_t len,
+                             unsigned long seed)
+{
+   const unsigned char *p = key;
+   unsigned long        h, k;
+   size_t               i;
+
+   h = seed ^ ((unsigned long)len * MMUL);
+   for (; len >= sizeof k; len -= sizeof k, p += sizeof k) {
+      memcpy(&k, p, sizeof k);
+      k *= MMUL;
+      k ^= k >> MSHIFT;
+      k *= MMUL;
+#if ULONG_MAX > 4294967295UL
+      h ^= k;
+      h *= MMUL;
+#else
+      h *= MMUL;
+      h ^= k;
+#endif
+   }
+   if (len) {                     /* the last partial word */
+      k = 0;
+      for (i = len; i-- > 0; ) k = (k << 8) | p[i];
+      h ^= k;
+      h *= MMUL;
+   }
+   h ^= h >> MFIN1;
+   h *= MMUL;
+   h ^= h >> MFIN2;
+   return h;
+} /* memhash */
+
+/* 1------------------1 */
+
+/* Hash len bytes at key, a word at a time */
+unsigned long hshmemhash(const void *key, size_t len)
+{
+   return memhash(key, len, MSEED1);
+} /* hshmemhash */
+
+/* 1------------------1 */
+
+/* ReHash len bytes at key, independent of hshmemhash */
+unsigned long hshmemrehash(const void *key, size_t len)
+{
+   return memhash(key, len, MSEED2);
+} /* hshmemrehash */
+
 /* -------------- File hashlib.c ------------------ */
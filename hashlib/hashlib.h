@@ -2,6 +2,8 @@
 #ifndef hashlib_h
 #define hashlib_h
 
+#include <stddef.h>       /* size_t */
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -39,6 +41,20 @@ extern "C"
   implementable.  It has been added. This also requires that
   a 'hdeleted' value be added to the status.
   The table actually holds hentries-hdeleted active entries.
+
+  v 1.0.0.4 Added hshinitopts, and the hshINCREMENTAL mode.
+  v 1.0.0.5 Added hshlookup.
+  v 1.0.0.6 Added hshmemhash and hshmemrehash.
+  v 1.0.0.7 Added hshopts.reserve and hshinsertmany.
+  v 1.0.0.8 Added the hshARENA mode and hshaalloc.
+  v 1.0.0.9 Added the hshSWISS mode.
+  v 1.0.1.0 Added the hshROBIN mode.
+  v 1.0.1.1 Added the hshSMALL mode.
+  v 1.0.1.2 Added hshfindmany.
+  v 1.0.1.3 Added hshwalkrange.
+  v 1.0.1.4 Bigger tables with 64 bit longs, huge pages on Linux.
+  v 1.0.1.5 hshSMALL holds 8 items, searched by tag bytes.
+  v 1.0.1.6 hshfindmany prefetches only in big tables.
 */
 
 /* This is an example of object oriented programming in C, in   */
@@ -53,6 +69,12 @@ extern "C"
 /* items of arbitrary types.  The hshkill() function will       */
 /* release all associated storage, after which hshinit() is     */
 /* needed before using the database again.                      */
+/* Re-entrant means that separate tables may be used by         */
+/* separate threads freely.  One table may only be used by one  */
+/* thread at a time, as every operation, hshfind() included,    */
+/* updates the statistics.  The exception is hshlookup(), which */
+/* writes nothing, so many threads may use it at once on a      */
+/* table that is not being changed.                             */
 
 /* The pointers returned by hshinsert() and hshfind() may be    */
 /* used to modify the data items, PROVIDED THAT such does NOT   */
@@ -67,6 +89,60 @@ typedef struct hshtag hshtbl;
 /* Possible error returns, powers of 2 */
 enum hsherr {hshOK = 0, hshNOMEM, hshTBLFULL, hshINTERR = 4};
 
+/* Modes for hshinitopts.  Flags, may be or'ed together.        */
+/* hshINCREMENTAL: when the table has to grow, insertions move  */
+/* a few entries at a time into the larger table, rather than   */
+/* one insertion moving all of them.  This bounds the time any  */
+/* one insertion can take.  Until all are moved finds look in   */
+/* both tables, and walks visit the new table then the old.     */
+/* Only hshinsert moves entries, so hshfind and hshdelete are   */
+/* as safe during a walk as ever.                               */
+/* hshARENA: new items are copied by opts.adupe, which takes    */
+/* its storage from hshaalloc(), in place of the dupe function. */
+/* hshkill then frees all the storage at once, and never calls  */
+/* the undupe function.  dupe and undupe may be NULL.  Items    */
+/* taken out by hshdelete stay valid until hshkill.             */
+/* hshSWISS: a table of a power of 2 size, searched 16 slots at */
+/* a time through a byte per slot holding 7 bits of the hash.   */
+/* No division, and a search touches one or two cache lines of  */
+/* these bytes where double hashing may touch one per probe.    */
+/* rehash is never called.  A probe counts a group of 16 slots. */
+/* hshROBIN: Robin Hood hashing in a table of a power of 2 size. */
+/* Items are kept in order of their distance from home, which   */
+/* bounds the search for an absent item, and hshdelete moves    */
+/* the following items back rather than leaving DELETED slots,  */
+/* so a table with many deletions never slows down or has to be */
+/* reorganized for them.  rehash is never called, and hdeleted  */
+/* stays 0.  Since hshdelete moves items, it must not be called */
+/* from within a walk of the same table.                        */
+/* hshINCREMENTAL, hshSWISS and hshROBIN exclude each other,    */
+/* hshinitopts fails if more than one is given.                 */
+/* hshSMALL: up to 8 items are kept in slots allocated along    */
+/* with the table, and searched by matching a tag byte of each  */
+/* hash all at once; rehash is not called and a search counts   */
+/* one probe.  The 9th item moves them all to the usual layout, */
+/* or that of hshSWISS or hshROBIN if given.  Ignored if        */
+/* reserve is over 8.  hshdelete moves an item into the gap, so */
+/* while the table is small it must not be called in a walk.    */
+enum hshmode {hshDEFAULT = 0, hshINCREMENTAL = 1, hshARENA = 2,
+              hshSWISS = 4, hshROBIN = 8, hshSMALL = 16};
+
+/* A hsharenadupfn() is the hshdupfn of the hshARENA mode. It   */
+/* copies the item into space from hshaalloc(master, size),     */
+/* and returns NULL if that fails.                              */
+typedef void *(*hsharenadupfn)(void *item, hshtbl *master);
+
+/* Options for hshinitopts.  All zero gives a hshinit table     */
+/* reserve: the number of entries the table should be able to   */
+/* hold before it first has to grow.  0 for the usual small     */
+/* start.  hshinitopts fails if it is beyond the largest table. */
+/* adupe: the dupe function for hshARENA, otherwise unused.     */
+typedef struct hshopts {
+   unsigned int  mode;            /* hshmode flags */
+   unsigned long reserve;         /* expected entries */
+   hsharenadupfn adupe;           /* for hshARENA */
+} hshopts;
+
 /* NOTE: probes and misses aids evaluating hash functions       */
 typedef struct hshstats {
    unsigned long probes, misses,  /* usage statistics */
@@ -136,16 +212,60 @@ hshtbl *hshinit(hshfn hash, hshfn rehash,
 
 /* 1------------------1 */
 
+/* initialize with options, see hshopts. NULL opts is the same */
+/* as hshinit.  The options are copied and may be discarded    */
+hshtbl *hshinitopts(hshfn hash, hshfn rehash,
+                    hshcmpfn cmp,
+                    hshdupfn dupe, hshfreefn undupe,
+                    int      hdebug,
+                    const hshopts *opts);
+
+/* 1------------------1 */
+
 /* destroy the data base. Accepts NULL and does nothing */
 void   hshkill(hshtbl *master);
 
 /* 1------------------1 */
 
+/* allocate size bytes, suitably aligned for any type, that     */
+/* belong to master and are freed by hshkill(master) with the   */
+/* rest of it.  There is no other way to free them.  Meant for  */
+/* hsharenadupfn functions, but usable in any mode.  NULL when  */
+/* out of memory.                                               */
+void * hshaalloc(hshtbl *master, size_t size);
+
+/* 1------------------1 */
+
 /* find an existing entry. NULL == notfound */
 void * hshfind(hshtbl *master, void *item);
 
 /* 1------------------1 */
 
+/* find count items, each size bytes long, held in the array at */
+/* items, as if by hshfind on each in turn.  The items are      */
+/* hashed a block at a time and the table slots they need are   */
+/* fetched ahead of the searches, which pays off when the table */
+/* is much larger than the cache; a table of under 8 MB of      */
+/* slots is just searched item by item.  If results is not      */
+/* NULL, results[i] receives what hshfind would have returned  */
+/* for item i.  Returns the number of items found.              */
+unsigned long hshfindmany(hshtbl *master, void *items,
+                          unsigned long count, size_t size,
+                          void **results);
+
+/* 1------------------1 */
+
+/* find an existing entry. NULL == notfound      */
+/* Unlike hshfind this never writes to master,   */
+/* so concurrent readers may share a table that  */
+/* nothing is changing.  The probes and misses   */
+/* it makes are added to *stats, unless NULL,    */
+/* instead of to the table statistics.  Only     */
+/* those two fields of *stats are touched.       */
+void * hshlookup(const hshtbl *master, void *item, hshstats *stats);
+
+/* 1------------------1 */
+
 /* delete an existing entry. NULL == notfound      */
 /* Disposal of the storage returned by hshdelete   */
 /* (originally created by hshdupfn) is up to the   */
@@ -160,6 +280,19 @@ void * hshinsert(hshtbl *master, void *item);
 
 /* 1------------------1 */
 
+/* insert count items, each size bytes long, held in the array  */
+/* at items, as if by hshinsert on each in turn, except that    */
+/* the table grows once, if at all, before the first.  If       */
+/* stored is not NULL, stored[i] receives what hshinsert would  */
+/* have returned for item i.  Returns the number of items       */
+/* stored or found already there; less than count means a      */
+/* failure, see herror.                                         */
+unsigned long hshinsertmany(hshtbl *master, void *items,
+                            unsigned long count, size_t size,
+                            void **stored);
+
+/* 1------------------1 */
+
 /* apply exec to all entries in table. 0 = success */
 /* The order of application is arbitrary.  If exec */
 /* returns non-zero (error) the walk stops         */
@@ -168,6 +301,18 @@ int    hshwalk(hshtbl *master, hshexecfn exec, void *datum);
 
 /* 1------------------1 */
 
+/* apply exec to the entries in part part, counting from 0, */
+/* of parts equal parts of the table, as hshwalk would.     */
+/* Walking every part once visits every entry once.  This   */
+/* writes nothing in the table, so several threads may walk */
+/* different parts at once, with a datum each, provided     */
+/* nothing changes the table meanwhile.  -1 when part is    */
+/* not below parts, else as hshwalk.                        */
+int    hshwalkrange(hshtbl *master, unsigned long part,
+                    unsigned long parts, hshexecfn exec, void *datum);
+
+/* 1------------------1 */
+
 /* return various statistics on use of this hshtbl */
 hshstats hshstatus(hshtbl *master);
 
@@ -181,6 +326,20 @@ unsigned long hshstrhash(const char * string);
 /* ReHash a string quantity */
 unsigned long hshstrehash(const char * string);
 
+/* 1------------------1 */
+
+/* Hash len bytes at key.  These take a machine word per step */
+/* rather than a byte, need no terminating nul, and spread    */
+/* similar keys, such as x_000123 and x_000124, evenly.  They */
+/* are the better choice unless hash values must match those  */
+/* of hshstrhash and hshstrehash, or of another machine.      */
+unsigned long hshmemhash(const void *key, size_t len);
+
+/* 1------------------1 */
+
+/* ReHash len bytes at key.  Independent of hshmemhash */
+unsigned long hshmemrehash(const void *key, size_t len);
+
 #ifdef __cplusplus
 }      /* Corrected per David Titkin 2005-03-14 */
 #endif
@@ -0,0 +1,365 @@
+/* -------------- File hashlib.hpp ------------------ */
+#ifndef hashlib_hpp
+#define hashlib_hpp
+
+/* A typed C++ front end to the hashlib algorithm.
+
+   hashlib::HashTable<Key, Value, Hash, Eq> is a table of Values
+   looked up by Key, with the double hashing, prime table sizes,
+   threshold and DELETED handling of a hshinit table.  The
+   difference is that the types are known when it is compiled:
+
+   Hash and Eq are function objects, called directly, and the
+   compiler can inline them, where hashlib calls its hash, rehash
+   and cmp functions through pointers.
+
+   Keys and Values are stored in the slots themselves, moved in
+   on insertion and out when the table grows, instead of being
+   copied by a dupe function into storage of their own and freed
+   by undupe.  A search compares the stored hash, then calls Eq
+   with no further pointer to follow.
+
+   There is no rehash function.  The step between probes comes
+   from mixing the hash itself, and is derived again, rather than
+   stored, whenever it is needed.  Hash should give full width
+   values; std::hash of an integer, the identity, does well
+   enough, as the table size is prime.
+
+   Needs C++11.  The C interface in hashlib.h is unchanged, and
+   this header does not need hashlib.c, only the hshstats type.
+
+   As in hashlib, the pointers returned by insert and find stay
+   valid until the table grows, that is until the next insert of
+   a new key, or until the key is erased.  Unlike hashlib the
+   key of a stored entry may not be changed at all.
+
+   v 1.0.0.0 2026-10-18 First version, on hashlib 1.0.1.2
+   v 1.0.0.1 2026-10-18 Sizes to 2**40, as hashlib 1.0.1.4
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "hashlib.h"
+
+namespace hashlib {
+
+template <class Key, class Value,
+          class Hash = std::hash<Key>, class Eq = std::equal_to<Key> >
+class HashTable {
+public:
+   /* An empty table, sized to hold reserve entries before it */
+   /* first grows.  Check status().herror if that matters,    */
+   /* hshTBLFULL when reserve is beyond the largest table.    */
+   explicit HashTable(std::size_t reserve = 0,
+                      const Hash &hash = Hash(), const Eq &eq = Eq())
+      : tbl(nullptr), sz(0), hasher(hash), equal(eq)
+   {
+      st.probes = st.misses = st.hentries = st.hdeleted = 0;
+      st.herror = hshOK;
+      st.version = VERSION;
+      if (!resize(sizefor(reserve)))
+         st.herror = (enum hsherr)(st.herror | hshTBLFULL);
+   }
+
+   ~HashTable() { destroy(); }
+
+   HashTable(const HashTable &) = delete;
+   HashTable &operator=(const HashTable &) = delete;
+
+   HashTable(HashTable &&other) noexcept
+      : tbl(other.tbl), sz(other.sz), st(other.st),
+        hasher(std::move(other.hasher)), equal(std::move(other.equal))
+   {
+      other.tbl = nullptr;
+      other.sz = 0;
+      other.st.hentries = other.st.hdeleted = 0;
+   }
+
+   HashTable &operator=(HashTable &&other) noexcept
+   {
+      if (this != &other) {
+         destroy();
+         tbl = other.tbl; sz = other.sz; st = other.st;
+         hasher = std::move(other.hasher);
+         equal = std::move(other.equal);
+         other.tbl = nullptr;
+         other.sz = 0;
+         other.st.hentries = other.st.hdeleted = 0;
+      }
+      return *this;
+   }
+
+   /* 1------------------1 */
+
+   /* Insert key with value, both moved in if given as rvalues. */
+   /* Returns the stored value, which is the one already there, */
+   /* left unchanged, when key is present.  nullptr on failure, */
+   /* see status().herror.  As in hshinsert, the table grows    */
+   /* first when it has reached the threshold.                  */
+   template <class K, class V>
+   Value *insert(K &&key, V &&value)
+   {
+      std::size_t h, i, step;
+      Slot       *p;
+
+      if ((tspace() <= 0) && !resize(nextsize())) {
+         st.herror = (enum hsherr)(st.herror | hshTBLFULL);
+         return nullptr;
+      }
+      h = hasher(key);
+      i = h % sz;
+      for (step = 0; ; ) {
+         st.probes++;
+         p = &tbl[i];
+         if (EMPTY == p->state) break;
+         if ((USED == p->state) && (p->hash == h)
+             && equal(p->entry()->key, key))
+            return &p->entry()->value;
+         if (!step) step = stepfor(h);
+         st.misses++;
+         if ((i += step) >= sz) i -= sz;
+      }
+      new (&p->data) Entry(std::forward<K>(key), std::forward<V>(value));
+      p->hash = h;
+      p->state = USED;
+      st.hentries++;
+      return &p->entry()->value;
+   }
+
+   /* 1------------------1 */
+
+   /* The value stored for key, nullptr when absent */
+   Value *find(const Key &key)
+   {
+      Slot *p = locate(key, st);
+
+      return p ? &p->entry()->value : nullptr;
+   }
+
+   /* 1------------------1 */
+
+   /* As find, but writing nothing, as hshlookup.  The probes */
+   /* and misses go to *stats, when not nullptr.              */
+   const Value *lookup(const Key &key, hshstats *stats = nullptr) const
+   {
+      hshstats  local = hshstats();
+      Slot     *p;
+
+      p = locate(key, stats ? *stats : local);
+      return p ? &p->entry()->value : nullptr;
+   }
+
+   /* 1------------------1 */
+
+   /* Remove key and destroy its entry, leaving a DELETED slot */
+   /* as hshdelete does.  false when key is absent.            */
+   bool erase(const Key &key)
+   {
+      Slot *p = locate(key, st);
+
+      if (!p) return false;
+      p->entry()->~Entry();
+      p->state = GONE;
+      st.hdeleted++;
+      return true;
+   }
+
+   /* 1------------------1 */
+
+   /* Call fn(key, value) for all entries, in no particular   */
+   /* order, until it returns non-zero, which is returned, as */
+   /* by hshwalk.  fn must not insert or erase.               */
+   template <class Fn>
+   int walk(Fn fn)
+   {
+      std::size_t i;
+      int         err;
+
+      for (i = 0; i < sz; i++)
+         if ((USED == tbl[i].state)
+             && (err = fn(static_cast<const Key &>(tbl[i].entry()->key),
+                          tbl[i].entry()->value)))
+            return err;
+      return 0;
+   }
+
+   /* 1------------------1 */
+
+   /* The statistics, as hshstatus gives them.  hentries       */
+   /* includes the DELETED slots, and version is that of this  */
+   /* header.                                                  */
+   hshstats status() const { return st; }
+
+   /* The number of entries present */
+   std::size_t size() const { return st.hentries - st.hdeleted; }
+
+private:
+   enum {EMPTY = 0, USED = 1, GONE = 2};
+   enum {VERSION = 1001, FIRSTN = 8, INITSZ = 17};
+
+   struct Entry {
+      Key   key;
+      Value value;
+
+      template <class K, class V>
+      Entry(K &&k, V &&v)
+         : key(std::forward<K>(k)), value(std::forward<V>(v)) {}
+   };
+
+   /* value initialized, every slot starts EMPTY */
+   struct Slot {
+      std::size_t    hash;
+      unsigned char  state;
+      typename std::aligned_storage<sizeof(Entry),
+                                    alignof(Entry)>::type data;
+
+      Entry *entry() { return reinterpret_cast<Entry *>(&data); }
+   };
+
+   Slot        *tbl;
+   std::size_t  sz;
+   hshstats     st;
+   Hash         hasher;
+   Eq           equal;
+
+   /* 1------------------1 */
+
+   /* As in hashlib.c, a prime slightly less than 2**(FIRSTN + i) */
+   static std::size_t ithprime(std::size_t i)
+   {
+      static const int primetbl[] = {45, 45, 41, 45, 45, 45, 45, 49,
+                                     57, 49, 41, 45, 59, 55, 57, 61,
+                                     63, 61, 45, 79,
+#if SIZE_MAX > 4294967295UL
+                                     57, 43, 41, 61, 65, 49, 41, 49,
+                                     65, 45, 45, 67, 87,
+#endif
+                                     0};
+
+      if ((i < sizeof primetbl / sizeof primetbl[0]) && primetbl[i])
+         return ((std::size_t)1 << (FIRSTN + i)) - primetbl[i];
+      return 0;
+   }
+
+   static std::size_t tthresh(std::size_t size)
+   {
+      return size - (size >> 3);
+   }
+
+   long tspace() const
+   {
+      return (long)tthresh(sz) - (long)st.hentries;
+   }
+
+   /* The smallest size holding n entries below the threshold */
+   static std::size_t sizefor(std::size_t n)
+   {
+      std::size_t size, i;
+
+      size = INITSZ;
+      for (i = 0; size && (tthresh(size) <= n); i++)
+         size = ithprime(i);
+      return size;
+   }
+
+   /* The same size when dropping the DELETED slots frees     */
+   /* enough, else the next prime, as nextsize in hashlib.c. */
+   std::size_t nextsize() const
+   {
+      std::size_t size, i;
+
+      if (st.hdeleted > st.hentries / 4) return sz;
+      size = ithprime(0);
+      for (i = 1; size && (size <= sz); i++)
+         size = ithprime(i);
+      return size;
+   }
+
+   /* The probe step for hash h, 1 up to sz / 8, from bits of */
+   /* h that h % sz has not used                              */
+   std::size_t stepfor(std::size_t h) const
+   {
+      h *= (std::size_t)0x9e3779b97f4a7c15ULL;
+      return (h ^ (h >> (sizeof h * 4))) % (sz >> 3) + 1;
+   }
+
+   /* 1------------------1 */
+
+   /* The slot holding key, nullptr when absent */
+   Slot *locate(const Key &key, hshstats &s) const
+   {
+      std::size_t h, i, step;
+      Slot       *p;
+
+      if (!sz) return nullptr;   /* moved from, or failed */
+      h = hasher(key);
+      i = h % sz;
+      for (step = 0; ; ) {
+         s.probes++;
+         p = &tbl[i];
+         if (EMPTY == p->state) return nullptr;
+         if ((USED == p->state) && (p->hash == h)
+             && equal(p->entry()->key, key))
+            return p;
+         if (!step) step = stepfor(h);
+         s.misses++;
+         if ((i += step) >= sz) i -= sz;
+      }
+   }
+
+   /* 1------------------1 */
+
+   /* Move all entries into a new table of newsize, false on */
+   /* failure when the table is left as it was.              */
+   bool resize(std::size_t newsize)
+   {
+      Slot        *newtbl, *oldtbl, *p;
+      std::size_t  oldsize, i, j, step;
+
+      if (!newsize || !(newtbl = new (std::nothrow) Slot[newsize]())) {
+         if (newsize) st.herror = (enum hsherr)(st.herror | hshNOMEM);
+         return false;
+      }
+      oldtbl = tbl; oldsize = sz;
+      tbl = newtbl; sz = newsize;
+      for (j = 0; j < oldsize; j++) {
+         if (USED != oldtbl[j].state) continue;
+         i = oldtbl[j].hash % sz;
+         for (step = 0; EMPTY != tbl[i].state; ) {
+            if (!step) step = stepfor(oldtbl[j].hash);
+            if ((i += step) >= sz) i -= sz;
+         }
+         p = &tbl[i];
+         new (&p->data) Entry(std::move(*oldtbl[j].entry()));
+         oldtbl[j].entry()->~Entry();
+         p->hash = oldtbl[j].hash;
+         p->state = USED;
+      }
+      delete[] oldtbl;
+      st.hentries -= st.hdeleted;
+      st.hdeleted = 0;
+      return true;
+   }
+
+   /* 1------------------1 */
+
+   void destroy()
+   {
+      std::size_t i;
+
+      for (i = 0; i < sz; i++)
+         if (USED == tbl[i].state) tbl[i].entry()->~Entry();
+      delete[] tbl;
+      tbl = nullptr;
+      sz = 0;
+   }
+}; /* HashTable */
+
+} /* namespace hashlib */
+
+#endif
+/* -------------- File hashlib.hpp ------------------ */
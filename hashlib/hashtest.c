@@ -8,6 +8,8 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include "hashlib.h"
 #include "cokusmt.h"
 
@@ -729,6 +731,799 @@ void dotest8(unsigned long p)
 
 /* 1------------------1 */
 
+/* Ninth test - like 4, with and without hshINCREMENTAL.    */
+/* The most probes made by a single insertion stand for the */
+/* worst insertion time.  Without hshINCREMENTAL it grows   */
+/* with the table, with it the bound is set by MIGRATESTEP. */
+/* Both tables must then hold and find the same values.     */
+void dotest9(unsigned long p)
+{
+   int           err, j;
+   unsigned long i, before, probes, worst, worstat, missing;
+   t1item        item, *stored;
+   hshtbl       *h;
+   hshopts       opts;
+   histogram     dtag;
+
+   printf("HASHLIB test09\n");
+   if (!p) p = 10000;
+   for (j = 0; j < 2; j++) {
+      opts.mode = j ? hshINCREMENTAL : hshDEFAULT;
+      opts.reserve = 0;
+      h = hshinitopts(t1hash,             /* hash function */
+                      t1rehash,           /* rehash function */
+                      t1cmp,              /* compare function */
+                      t1dupe,             /* dupe function */
+                      t1undupe,           /* hshfree function */
+                      1,                  /* use debug output */
+                      &opts);
+
+      printf("\nNew %s table, inserting %lu values\n",
+             j ? "incremental" : "default", p);
+      seedMT(4357U);
+      item.count = item.timesfound = 0;
+      worst = worstat = 0;
+      for (i = 0; i < p; i++) {
+         item.value = randomMT();
+         before = hshstatus(h).probes;
+         stored = hshinsert(h, &item);
+         stored->count++;
+         probes = hshstatus(h).probes - before;
+         if (probes > worst) {
+            worst = probes;
+            worstat = i;
+         }
+      }
+      printf("Worst insertion made %lu probes, at %lu\n",
+             worst, worstat);
+      showstate(h);
+
+      seedMT(4357U);
+      missing = 0;
+      for (i = 0; i < p; i++) {
+         item.value = randomMT();
+         if ((stored = hshfind(h, &item))) stored->timesfound++;
+         else missing++;
+      }
+      printf("%lu values not found\n", missing);
+
+      printf("Walking ");
+      clearhistogram(&dtag);
+      err = hshwalk(h, getcounts, &dtag);
+      printf("returned %d\n", err);
+      showinserts(&dtag);
+
+      hshkill(h);
+   }
+} /* dotest9 */
+
+/* 1------------------1 */
+
+/* Tenth test - search with hshlookup, which must leave the   */
+/* table statistics alone and count its probes and misses     */
+/* where told.  Every other value searched for was inserted.  */
+/* The same search by hshfind must then find the same items,  */
+/* making the same probes and misses.                         */
+void dotest10(unsigned long p)
+{
+   unsigned long i, lookfound, findfound;
+   t1item        item, *stored;
+   hshtbl       *h;
+   hshstats      before, after, mine;
+
+   printf("HASHLIB test10\n");
+   h = hshinit(t1hash,             /* hash function */
+               t1rehash,           /* rehash function */
+               t1cmp,              /* compare function */
+               t1dupe,             /* dupe function */
+               t1undupe,           /* hshfree function */
+               1);                 /* use debug output */
+
+   if (!p) p = 10000;
+   printf("\nNew table, inserting %lu values\n", p);
+   seedMT(4357U);
+   item.count = item.timesfound = 0;
+   for (i = 0; i < p; i++) {
+      item.value = randomMT();
+      stored = hshinsert(h, &item);
+      stored->count++;
+   }
+   showstate(h);
+
+   printf("\nLooking up %lu values\n", p);
+   before = hshstatus(h);
+   mine.probes = mine.misses = 0;
+   seedMT(4357U);
+   lookfound = 0;
+   for (i = 0; i < p; i++) {
+      item.value = randomMT() + (i & 1);
+      if (hshlookup(h, &item, &mine)) lookfound++;
+   }
+   after = hshstatus(h);
+   showstate(h);
+   printf("Table statistics %s\n",
+          (before.probes == after.probes && before.misses == after.misses)
+          ? "unchanged" : "CHANGED");
+   printf("%lu found, Probes=%lu, Misses=%lu\n",
+          lookfound, mine.probes, mine.misses);
+
+   printf("\nFinding the same values\n");
+   seedMT(4357U);
+   findfound = 0;
+   for (i = 0; i < p; i++) {
+      item.value = randomMT() + (i & 1);
+      if (hshfind(h, &item)) findfound++;
+   }
+   after = hshstatus(h);
+   printf("%lu found, Probes=%lu, Misses=%lu\n", findfound,
+          after.probes - before.probes, after.misses - before.misses);
+
+   hshkill(h);
+} /* dotest10 */
+
+/* 1------------------1 */
+
+/* String keyed items for test 11, with the length kept */
+typedef struct t11tag {
+   size_t  len;
+   char    key[16];
+} t11item, *t11itemptr;
+
+/* 1------------------1 */
+
+unsigned long t11strhash(void *item)
+{
+   return hshstrhash(((t11itemptr)item)->key);
+} /* t11strhash */
+
+/* 1------------------1 */
+
+unsigned long t11strrehash(void *item)
+{
+   return hshstrehash(((t11itemptr)item)->key);
+} /* t11strrehash */
+
+/* 1------------------1 */
+
+unsigned long t11memhash(void *item)
+{
+   t11itemptr t11p = item;
+
+   return hshmemhash(t11p->key, t11p->len);
+} /* t11memhash */
+
+/* 1------------------1 */
+
+unsigned long t11memrehash(void *item)
+{
+   t11itemptr t11p = item;
+
+   return hshmemrehash(t11p->key, t11p->len);
+} /* t11memrehash */
+
+/* 1------------------1 */
+
+int t11cmp(void *litem, void *ritem)
+{
+   t11itemptr t11lp = litem,
+              t11rp = ritem;
+
+   if (t11lp->len != t11rp->len) return t11lp->len > t11rp->len ? 1 : -1;
+   return memcmp(t11lp->key, t11rp->key, t11lp->len);
+} /* t11cmp */
+
+/* 1------------------1 */
+
+void *t11dupe(void *item)
+{
+   t11itemptr tdupe;
+
+   if ((tdupe = malloc(sizeof *tdupe))) *tdupe = *(t11itemptr)item;
+   return tdupe;
+} /* t11dupe */
+
+/* 1------------------1 */
+
+/* Insert keys[0..p-1], find them, then find keys[p..2p-1], */
+/* which are absent, with one pair of hash functions.  Show */
+/* probes per operation and the time per operation.         */
+void t11run(const char *name, hshfn hash, hshfn rehash,
+            t11itemptr keys, unsigned long p)
+{
+   hshtbl        *h;
+   hshstats       hs;
+   unsigned long  i, found, probes[3];
+   clock_t        t[4];
+
+   h = hshinit(hash, rehash, t11cmp, t11dupe, t1undupe, 0);
+   t[0] = clock();
+   for (i = 0; i < p; i++)
+      if (!hshinsert(h, &keys[i])) printf("Store failure\n");
+   t[1] = clock();
+   probes[0] = hshstatus(h).probes;
+   for (found = i = 0; i < p; i++)
+      if (hshfind(h, &keys[i])) found++;
+   t[2] = clock();
+   probes[1] = hshstatus(h).probes - probes[0];
+   for (i = p; i < 2 * p; i++)
+      if (hshfind(h, &keys[i])) found++;
+   t[3] = clock();
+   hs = hshstatus(h);
+   probes[2] = hs.probes - probes[0] - probes[1];
+   printf("%-13s", name);
+   for (i = 0; i < 3; i++)
+      printf("%7.2f %8.1f", (double)probes[i] / p,
+             1e9 * (t[i+1] - t[i]) / CLOCKS_PER_SEC / p);
+   printf("%s\n", found == p ? "" : "  WRONG FINDS");
+   hshkill(h);
+} /* t11run */
+
+/* 1------------------1 */
+
+/* Eleventh test - string hash functions.  Compare the word */
+/* at a time hshmemhash pair against hshstrhash pair, on    */
+/* machine made names like x_000123, then on random names.  */
+/* Times vary by machine, so this is not in the testsuite.  */
+void dotest11(unsigned long p)
+{
+   t11itemptr    keys;
+   unsigned long i;
+   size_t        j;
+   int           set;
+
+   printf("HASHLIB test11\n");
+   if (!p) p = 100000;
+   if (p > 999999) p = 999999;
+   if (!(keys = malloc(2 * p * sizeof *keys))) {
+      printf("No memory\n");
+      return;
+   }
+   seedMT(4357U);
+   for (set = 0; set < 2; set++) {
+      for (i = 0; i < 2 * p; i++) {
+         if (0 == set)  /* absent keys start with y */
+            sprintf(keys[i].key, "%c_%06lu", i < p ? 'x' : 'y', i % p);
+         else {  /* absent keys are in upper case */
+            keys[i].len = 6 + randomMT() % 9;
+            for (j = 0; j < keys[i].len; j++)
+               keys[i].key[j] = (i < p ? 'a' : 'A') + randomMT() % 26;
+            keys[i].key[j] = '\0';
+         }
+         keys[i].len = strlen(keys[i].key);
+      }
+      printf("\n%lu %s names present, %lu absent\n", p,
+             set ? "random 6 to 14 letter" : "x_000000 style", p);
+      printf("%-13s%16s%16s%16s\n", "",
+             "insert", "find", "find absent");
+      printf("%-13s%16s%16s%16s\n", "hash pair",
+             "probes  ns/op", "probes  ns/op", "probes  ns/op");
+      t11run("hshstrhash", t11strhash, t11strrehash, keys, p);
+      t11run("hshmemhash", t11memhash, t11memrehash, keys, p);
+   }
+   free(keys);
+} /* dotest11 */
+
+/* 1------------------1 */
+
+/* Twelfth test - load count values by hshinsert into a new  */
+/* table, into one reserved for count entries, and all at    */
+/* once by hshinsertmany.  Every third value repeats an      */
+/* earlier one.  The probes show the cost of the growth      */
+/* avoided; all three must then hold and find the same.      */
+void dotest12(unsigned long p)
+{
+   int           err, j;
+   unsigned long i, missing, stored;
+   t1item       *items, *found;
+   void        **where;
+   hshtbl       *h;
+   hshopts       opts;
+   histogram     dtag;
+
+   printf("HASHLIB test12\n");
+   if (!p) p = 10000;
+   items = malloc(p * sizeof *items);
+   where = malloc(p * sizeof *where);
+   if (!items || !where) {
+      printf("No memory\n");
+      free(items); free(where);
+      return;
+   }
+   seedMT(4357U);
+   for (i = 0; i < p; i++) {
+      items[i].value = (i % 3 == 2) ? items[i / 2].value : randomMT();
+      items[i].count = 1;
+      items[i].timesfound = 0;
+   }
+
+   for (j = 0; j < 3; j++) {
+      opts.mode = hshDEFAULT;
+      opts.reserve = (1 == j) ? p : 0;
+      h = hshinitopts(t1hash,             /* hash function */
+                      t1rehash,           /* rehash function */
+                      t1cmp,              /* compare function */
+                      t1dupe,             /* dupe function */
+                      t1undupe,           /* hshfree function */
+                      1,                  /* use debug output */
+                      &opts);
+      printf("\n%s, %lu values\n", (0 == j) ? "New table, hshinsert"
+             : (1 == j) ? "Reserved table, hshinsert"
+             : "New table, hshinsertmany", p);
+      if (2 == j) {
+         stored = hshinsertmany(h, items, p, sizeof *items, where);
+         for (i = 0; i < p; i++)
+            if (!where[i] || ((t1itemptr)where[i])->value != items[i].value)
+               printf("Wrong item at %lu\n", i);
+      }
+      else {
+         for (stored = i = 0; i < p; i++)
+            if (hshinsert(h, &items[i])) stored++;
+      }
+      printf("%lu stored or found, ", stored);
+      showstate(h);
+
+      for (missing = i = 0; i < p; i++) {
+         if ((found = hshfind(h, &items[i]))) found->timesfound++;
+         else missing++;
+      }
+      printf("%lu values not found\n", missing);
+
+      printf("Walking ");
+      clearhistogram(&dtag);
+      err = hshwalk(h, getcounts, &dtag);
+      printf("returned %d\n", err);
+      showfinds(&dtag);
+
+      hshkill(h);
+   }
+   free(items);
+   free(where);
+} /* dotest12 */
+
+/* 1------------------1 */
+
+/* Items for test 13 are plain strings */
+unsigned long t13hash(void *item)
+{
+   return hshstrhash(item);
+} /* t13hash */
+
+/* 1------------------1 */
+
+unsigned long t13rehash(void *item)
+{
+   return hshstrehash(item);
+} /* t13rehash */
+
+/* 1------------------1 */
+
+int t13cmp(void *litem, void *ritem)
+{
+   return strcmp(litem, ritem);
+} /* t13cmp */
+
+/* 1------------------1 */
+
+void *t13dupe(void *item)
+{
+   char *tdupe;
+
+   if ((tdupe = malloc(strlen(item) + 1))) strcpy(tdupe, item);
+   return tdupe;
+} /* t13dupe */
+
+/* 1------------------1 */
+
+void t13undupe(void *item)
+{
+   free(item);
+} /* t13undupe */
+
+/* 1------------------1 */
+
+void *t13arenadupe(void *item, hshtbl *master)
+{
+   char *tdupe;
+
+   if ((tdupe = hshaalloc(master, strlen(item) + 1))) strcpy(tdupe, item);
+   return tdupe;
+} /* t13arenadupe */
+
+/* 1------------------1 */
+
+/* Thirteenth test - string items copied by malloc, then    */
+/* into the arena of a hshARENA table.  Shows the time per  */
+/* item to insert, find, and hshkill.  Times vary by        */
+/* machine, so this is not in the testsuite.                */
+void dotest13(unsigned long p)
+{
+   char         *keys;
+   unsigned long i, found;
+   size_t        j, len, want;
+   int           arena;
+   hshtbl       *h;
+   hshopts       opts;
+   clock_t       t[4];
+
+   printf("HASHLIB test13\n");
+   if (!p) p = 100000;
+   if (!(keys = malloc(p * 16))) {
+      printf("No memory\n");
+      return;
+   }
+   seedMT(4357U);
+   for (i = 0; i < p; i++) {  /* unique, 7 to 15 characters */
+      want = 7 + randomMT() % 9;
+      len = sprintf(&keys[i * 16], "%lx", i);
+      for (j = len; j < want; j++)   /* no hex digit, so unique */
+         keys[i * 16 + j] = 'g' + randomMT() % 20;
+      keys[i * 16 + j] = '\0';
+   }
+   printf("%lu names, 7 to 15 characters\n", p);
+   printf("%-8s%10s%10s%10s\n", "items", "insert", "find", "hshkill");
+   printf("%-8s%10s%10s%10s\n", "from", "ns/op", "ns/op", "ns/op");
+   for (arena = 0; arena < 2; arena++) {
+      opts.mode = arena ? hshARENA : hshDEFAULT;
+      opts.reserve = 0;
+      opts.adupe = t13arenadupe;
+      h = hshinitopts(t13hash, t13rehash, t13cmp,
+                      t13dupe, t13undupe, 0, &opts);
+      t[0] = clock();
+      for (i = 0; i < p; i++)
+         if (!hshinsert(h, &keys[i * 16])) printf("Store failure\n");
+      t[1] = clock();
+      for (found = i = 0; i < p; i++)
+         if (hshfind(h, &keys[i * 16])) found++;
+      t[2] = clock();
+      hshkill(h);
+      t[3] = clock();
+      printf("%-8s", arena ? "arena" : "malloc");
+      for (i = 0; i < 3; i++)
+         printf("%10.1f", 1e9 * (t[i+1] - t[i]) / CLOCKS_PER_SEC / p);
+      printf("%s\n", found == p ? "" : "  WRONG FINDS");
+   }
+   free(keys);
+} /* dotest13 */
+
+/* 1------------------1 */
+
+/* Insert items[0..p-1], find them, find absent[0..p-1], */
+/* then delete items[0..p-1], in a table of the given    */
+/* mode.  Show probes per operation and the time per     */
+/* operation.                                            */
+void t14run(const char *name, unsigned int mode,
+            t1itemptr items, t1itemptr absent, unsigned long p)
+{
+   hshtbl        *h;
+   hshopts        opts;
+   unsigned long  i, found, probes[5];
+   clock_t        t[5];
+   void          *gone;
+
+   opts.mode = mode;
+   opts.reserve = 0;
+   h = hshinitopts(t1hash, t1rehash, t1cmp, t1dupe, t1undupe, 0, &opts);
+   probes[0] = 0;
+   t[0] = clock();
+   for (i = 0; i < p; i++)
+      if (!hshinsert(h, &items[i])) printf("Store failure\n");
+   t[1] = clock();
+   probes[1] = hshstatus(h).probes;
+   for (found = i = 0; i < p; i++)
+      if (hshfind(h, &items[i])) found++;
+   t[2] = clock();
+   probes[2] = hshstatus(h).probes;
+   for (i = 0; i < p; i++)
+      if (hshfind(h, &absent[i])) found++;
+   t[3] = clock();
+   probes[3] = hshstatus(h).probes;
+   for (i = 0; i < p; i++)
+      if ((gone = hshdelete(h, &items[i]))) t1undupe(gone);
+   t[4] = clock();
+   probes[4] = hshstatus(h).probes;
+   printf("%-9s", name);
+   for (i = 0; i < 4; i++)
+      printf("%7.2f %7.1f", (double)(probes[i+1] - probes[i]) / p,
+             1e9 * (t[i+1] - t[i]) / CLOCKS_PER_SEC / p);
+   printf("%s\n", (found == p && 0 == hshstatus(h).hentries
+                              - hshstatus(h).hdeleted)
+                  ? "" : "  WRONG");
+   hshkill(h);
+} /* t14run */
+
+/* 1------------------1 */
+
+/* Fourteenth test - the hshSWISS engine against the usual  */
+/* double hashing, on count random values, at sizes from    */
+/* count / 1000 up.  A hshSWISS probe examines 16 slots.    */
+/* Times vary by machine, so this is not in the testsuite.  */
+void dotest14(unsigned long p)
+{
+   t1itemptr     items;
+   unsigned long i, n;
+
+   printf("HASHLIB test14\n");
+   if (!p) p = 1000000;
+   if (!(items = malloc(2 * p * sizeof *items))) {
+      printf("No memory\n");
+      return;
+   }
+   seedMT(4357U);
+   for (i = 0; i < 2 * p; i++) {  /* absent values are even */
+      items[i].value = (i < p) ? (randomMT() | 1) : (randomMT() & ~1UL);
+      items[i].count = 1;
+      items[i].timesfound = 0;
+   }
+   for (n = p / 1000 ? p / 1000 : p; ; n *= 10) {
+      if (n > p) n = p;
+      printf("\n%lu values\n", n);
+      printf("%-9s%15s%15s%15s%15s\n", "",
+             "insert", "find", "find absent", "delete");
+      printf("%-9s%15s%15s%15s%15s\n", "mode", "probes ns/op",
+             "probes ns/op", "probes ns/op", "probes ns/op");
+      t14run("default", hshDEFAULT, items, &items[p], n);
+      t14run("hshSWISS", hshSWISS, items, &items[p], n);
+      if (n == p) break;
+   }
+   free(items);
+} /* dotest14 */
+
+/* 1------------------1 */
+
+/* Probes per search of items[0..p-1] in h, the mean into */
+/* *mean and the time per search in ns into *ns.  Returns */
+/* the largest number of probes any search took.          */
+unsigned long t15finds(hshtbl *h, t1itemptr items, unsigned long p,
+                       double *mean, double *ns)
+{
+   unsigned long i, before, probes, most;
+   clock_t       t;
+
+   t = clock();
+   for (i = 0; i < p; i++) hshfind(h, &items[i]);
+   *ns = 1e9 * (clock() - t) / CLOCKS_PER_SEC / p;
+   before = hshstatus(h).probes;
+   for (most = i = 0; i < p; i++) {
+      probes = hshstatus(h).probes;
+      hshfind(h, &items[i]);
+      if (hshstatus(h).probes - probes > most)
+         most = hshstatus(h).probes - probes;
+   }
+   *mean = (double)(hshstatus(h).probes - before) / p;
+   return most;
+} /* t15finds */
+
+/* 1------------------1 */
+
+/* Fill a table of the given mode with items[0..p-1], then */
+/* churn it: delete the oldest item and insert a new one,  */
+/* rounds * p times.  Then search for the p items present  */
+/* and p absent.  Shows the time per churn operation, and  */
+/* for the searches the mean and largest probe counts and  */
+/* the time per search.                                    */
+void t15run(const char *name, unsigned int mode, t1itemptr items,
+            unsigned long p, unsigned long rounds)
+{
+   hshtbl        *h;
+   hshopts        opts;
+   unsigned long  i, most[2];
+   clock_t        t;
+   double         churn, mean[2], ns[2];
+   void          *gone;
+
+   opts.mode = mode;
+   opts.reserve = 0;
+   h = hshinitopts(t1hash, t1rehash, t1cmp, t1dupe, t1undupe, 0, &opts);
+   for (i = 0; i < p; i++) hshinsert(h, &items[i]);
+   t = clock();
+   for (i = 0; i < rounds * p; i++) {
+      if ((gone = hshdelete(h, &items[i]))) t1undupe(gone);
+      if (!hshinsert(h, &items[i + p])) printf("Store failure\n");
+   }
+   churn = 1e9 * (clock() - t) / CLOCKS_PER_SEC / (2 * rounds * p);
+   most[0] = t15finds(h, &items[rounds * p], p, &mean[0], &ns[0]);
+   most[1] = t15finds(h, &items[(rounds + 1) * p], p, &mean[1], &ns[1]);
+   printf("%-9s%8.1f", name, churn);
+   for (i = 0; i < 2; i++)
+      printf("%7.2f %5lu %7.1f", mean[i], most[i], ns[i]);
+   printf("%s\n", (hshstatus(h).hentries - hshstatus(h).hdeleted == p)
+                  ? "" : "  WRONG");
+   hshkill(h);
+} /* t15run */
+
+/* 1------------------1 */
+
+/* Fifteenth test - deletions.  count values are kept in a  */
+/* table while all of them are deleted and replaced 4 times */
+/* over, for each of the modes that search differently.     */
+/* Times vary by machine, so this is not in the testsuite.  */
+void dotest15(unsigned long p)
+{
+   t1itemptr     items;
+   unsigned long i, v;
+
+   printf("HASHLIB test15\n");
+   if (!p) p = 100000;
+   if (!(items = malloc(6 * p * sizeof *items))) {
+      printf("No memory\n");
+      return;
+   }
+   for (i = 0; i < 6 * p; i++) {  /* scrambled, all different */
+      v = (i * 2654435761UL) & 0xffffffffUL;
+      v = ((v ^ (v >> 16)) * 0x45d9f3bUL) & 0xffffffffUL;
+      items[i].value = v ^ (v >> 16);
+      items[i].count = 1;
+      items[i].timesfound = 0;
+   }
+   printf("%lu values, each replaced 4 times\n", p);
+   printf("%-9s%8s%20s%20s\n", "", "churn", "find", "find absent");
+   printf("%-9s%8s%20s%20s\n", "mode", "ns/op",
+          "probes  max   ns/op", "probes  max   ns/op");
+   t15run("default", hshDEFAULT, items, p, 4);
+   t15run("hshSWISS", hshSWISS, items, p, 4);
+   t15run("hshROBIN", hshROBIN, items, p, 4);
+   free(items);
+} /* dotest15 */
+
+/* 1------------------1 */
+
+/* Build tables of n of the items, rounds of them, in the */
+/* given mode, searching each for all of its items and as */
+/* many absent ones, items[64] on, 10 times.  Show the    */
+/* time per table to build and kill it, and per search.   */
+void t16run(const char *name, unsigned int mode, t1itemptr items,
+            unsigned long n, unsigned long rounds)
+{
+   hshtbl        *h;
+   hshopts        opts;
+   unsigned long  i, j, r, found;
+   clock_t        t, tbuild, tfind;
+
+   opts.mode = mode;
+   opts.reserve = 0;
+   tbuild = tfind = 0;
+   for (found = r = 0; r < rounds; r++) {
+      t = clock();
+      h = hshinitopts(t1hash, t1rehash, t1cmp, t1dupe, t1undupe,
+                      0, &opts);
+      for (i = 0; i < n; i++) hshinsert(h, &items[i]);
+      tbuild += clock() - t;
+      t = clock();
+      for (j = 0; j < 10; j++)
+         for (i = 0; i < n; i++) {
+            if (hshfind(h, &items[i])) found++;
+            if (hshfind(h, &items[64 + i])) found++;
+         }
+      tfind += clock() - t;
+      t = clock();
+      hshkill(h);
+      tbuild += clock() - t;
+   }
+   printf("%-9s%4lu%12.1f%12.1f%s\n", name, n,
+          1e9 * tbuild / CLOCKS_PER_SEC / rounds,
+          1e9 * tfind / CLOCKS_PER_SEC / rounds / (20 * n),
+          (found == 10 * n * rounds) ? "" : "  WRONG");
+} /* t16run */
+
+/* 1------------------1 */
+
+/* Sixteenth test - many small tables, with and without the */
+/* hshSMALL mode, holding 2 to 64 items.  count is the      */
+/* number of tables built for each.                         */
+/* Times vary by machine, so this is not in the testsuite.  */
+void dotest16(unsigned long p)
+{
+   t1item        items[128];
+   unsigned long i, n;
+
+   printf("HASHLIB test16\n");
+   if (!p) p = 100000;
+   seedMT(4357U);
+   for (i = 0; i < 128; i++) {  /* absent values are even */
+      items[i].value = (i < 64) ? (randomMT() | 1) : (randomMT() & ~1UL);
+      items[i].count = 1;
+      items[i].timesfound = 0;
+   }
+   printf("%lu tables of each size\n", p);
+   printf("%-9s%4s%12s%12s\n", "mode", "size",
+          "build+kill", "find");
+   printf("%-9s%4s%12s%12s\n", "", "", "ns/table", "ns/op");
+   for (n = 2; n <= 64; n *= 2) {
+      t16run("default", hshDEFAULT, items, n, p);
+      t16run("hshSMALL", hshSMALL, items, n, p);
+   }
+} /* dotest16 */
+
+/* 1------------------1 */
+
+/* Fill a table of the given mode with items[0..n-1], then */
+/* search for them and for absent[0..n-1], by hshfind one  */
+/* at a time and by hshfindmany, checking that both agree. */
+/* Shows the time per search of each.                      */
+void t17run(const char *name, unsigned int mode, t1itemptr items,
+            t1itemptr absent, unsigned long n, void **results)
+{
+   hshtbl        *h;
+   hshopts        opts;
+   unsigned long  i, found, many;
+   clock_t        t, dt[4];
+   int            bad;
+
+   opts.mode = mode;
+   opts.reserve = 0;
+   h = hshinitopts(t1hash, t1rehash, t1cmp, t1dupe, t1undupe, 0, &opts);
+   for (i = 0; i < n; i++) hshinsert(h, &items[i]);
+   t = clock();
+   for (found = i = 0; i < n; i++)
+      if (hshfind(h, &items[i])) found++;
+   dt[0] = clock() - t;
+   t = clock();
+   for (i = 0; i < n; i++)
+      if (hshfind(h, &absent[i])) found++;
+   dt[1] = clock() - t;
+   t = clock();
+   many = hshfindmany(h, items, n, sizeof *items, results);
+   dt[2] = clock() - t;
+   for (bad = 0, i = 0; i < n; i++)
+      if (!results[i]
+          || (((t1itemptr)results[i])->value != items[i].value))
+         bad = 1;
+   t = clock();
+   many += hshfindmany(h, absent, n, sizeof *absent, results);
+   dt[3] = clock() - t;
+   for (i = 0; i < n; i++)
+      if (results[i]) bad = 1;
+   printf("%-9s", name);
+   for (i = 0; i < 4; i++)
+      printf("%10.1f", 1e9 * dt[i] / CLOCKS_PER_SEC / n);
+   printf("%s\n", (found == n && many == n && !bad) ? "" : "  WRONG");
+   hshkill(h);
+} /* t17run */
+
+/* 1------------------1 */
+
+/* Seventeenth test - hshfindmany against hshfind, on count */
+/* random values, at sizes from count / 1000 up, where the  */
+/* larger tables no longer fit in the cache.                */
+/* Times vary by machine, so this is not in the testsuite.  */
+void dotest17(unsigned long p)
+{
+   t1itemptr     items;
+   void        **results;
+   unsigned long i, n;
+
+   printf("HASHLIB test17\n");
+   if (!p) p = 4000000;
+   items = malloc(2 * p * sizeof *items);
+   results = malloc(p * sizeof *results);
+   if (!items || !results) {
+      printf("No memory\n");
+      free(items);
+      return;
+   }
+   seedMT(4357U);
+   for (i = 0; i < 2 * p; i++) {  /* absent values are even */
+      items[i].value = (i < p) ? (randomMT() | 1) : (randomMT() & ~1UL);
+      items[i].count = 1;
+      items[i].timesfound = 0;
+   }
+   for (n = p / 1000 ? p / 1000 : p; ; n *= 10) {
+      if (n > p) n = p;
+      printf("\n%lu values\n", n);
+      printf("%-9s%20s%20s\n", "", "hshfind", "hshfindmany");
+      printf("%-9s%10s%10s%10s%10s\n", "mode", "ns/find",
+             "absent", "ns/find", "absent");
+      t17run("default", hshDEFAULT, items, &items[p], n, results);
+      t17run("hshSWISS", hshSWISS, items, &items[p], n, results);
+      t17run("hshROBIN", hshROBIN, items, &items[p], n, results);
+      if (n == p) break;
+   }
+   free(results);
+   free(items);
+} /* dotest17 */
+
+/* 1------------------1 */
+
 /* Test the hash library system */
 int main(int argc, char ** argv)
 {
@@ -751,10 +1546,19 @@ case 7: dotest7(); break;
 #ifdef MALLDBG
 case 8: dotest8(p); break;
 #endif
+case 9: dotest9(p); break;
+case 10: dotest10(p); break;
+case 11: dotest11(p); break;
+case 12: dotest12(p); break;
+case 13: dotest13(p); break;
+case 14: dotest14(p); break;
+case 15: dotest15(p); break;
+case 16: dotest16(p); break;
+case 17: dotest17(p); break;
 default:
         puts("Invalid test num\n");
         printf("Usage: %s test_num [count]\n", argv[0]);
-        puts("Test Use\n"
+        fputs("Test Use\n"
              "  1  Inject random values\n"
              "  2  Inject 20 sequential values\n"
              "  3  Inject 17 values, check reorg\n"
@@ -766,6 +1570,16 @@ default:
 #ifdef MALLDBG
              "  8  Check memory allocations freed on hshkill\n"
 #endif
+             , stdout);
+        puts("  9  Like 4, with and without incremental growth\n"
+             " 10  Search with hshlookup, then hshfind\n"
+             " 11  Benchmark string hashes, count names\n"
+             " 12  Load count values one by one and in bulk\n"
+             " 13  Benchmark malloc and arena items\n"
+             " 14  Benchmark the hshSWISS mode\n"
+             " 15  Benchmark deletions, hshROBIN mode\n"
+             " 16  Benchmark small tables, hshSMALL mode\n"
+             " 17  Benchmark hshfindmany against hshfind\n"
              "\n4 thru 6, odd counts suppress final hshkill"
             );
         return EXIT_FAILURE;
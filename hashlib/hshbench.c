@@ -0,0 +1,468 @@
+/* Benchmark of the hashlib operations, with the results in JSON.
+
+   Usage: hshbench [-k int|str] [-m mode] [-a] [-f from] [-t to]
+                   [-s seed]
+
+   For table sizes n of 10^from up to 10^to (default 2 to 6) this
+   times inserting n keys into a new table, finding them all,
+   finding n absent keys, walking the table and deleting the n
+   keys.  Each is reported as ns per operation and millions of
+   operations a second, and all but the walk also as the 50th,
+   99th and 99.9th percentile of the time single operations took.
+   Small tables are built over and over, so that each figure is
+   taken over at least a million operations.
+
+   -k  int keys, hashed as by t5hash of hashtest, or str keys
+       of 6 to 14 letters, hashed by hshmemhash.  Default int.
+   -m  default, incremental, swiss, robin or small, the hshmode.
+   -a  also the hshARENA mode.
+   -s  seed for the keys, default 4357.
+
+   The throughput is measured on passes without any timing of
+   single operations, the percentiles on separate passes which
+   time up to a million of them, less the cost of reading the
+   clock.  Needs a POSIX clock_gettime.  10^8 keys take about
+   20 GB of memory, and 10^9 about 200 GB, with tables of more
+   than 2**27 slots, which need 64 bit longs.
+*/
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "hashlib.h"
+#include "cokusmt.h"
+
+#define MAXSAMPLES 1000000
+#define MINOPS     1000000
+
+/* Keys of both kinds */
+typedef struct bitem {
+   unsigned long value;         /* int keys */
+   size_t        len;           /* str keys */
+   char          key[16];
+} bitem, *bitemptr;
+
+/* What the timed passes measure, for one operation */
+typedef struct phase {
+   double         seconds;      /* throughput passes */
+   unsigned long  ops;
+   double        *lat;          /* ns, from latency passes */
+   unsigned long  nlat;
+} phase;
+
+enum {INSERT, HIT, MISS, WALK, DELETE, PHASES};
+static const char *phasename[PHASES] =
+   {"insert", "hit", "miss", "walk", "delete"};
+
+static double overhead;         /* ns per clock reading */
+static int    inarena;          /* items belong to the table */
+
+/* 1------------------1 */
+
+/* The mixing of t5hash in hashtest.c */
+static unsigned long inthash(void *item)
+{
+   unsigned long work;
+
+   work = ((bitemptr)item)->value;
+   work += ~(work << 15);
+   work ^= ~(work << 22);
+   work += ~(work << 4);
+   work ^= ~(work << 9);
+   work += ~(work << 10);
+   work ^= ~(work << 2);
+   work += ~(work << 7);
+   work ^= ~(work << 12);
+   return work;
+} /* inthash */
+
+/* 1------------------1 */
+
+static unsigned long intrehash(void *item)
+{
+   return ((bitemptr)item)->value >> 3;
+} /* intrehash */
+
+/* 1------------------1 */
+
+static int intcmp(void *litem, void *ritem)
+{
+   unsigned long l = ((bitemptr)litem)->value,
+                 r = ((bitemptr)ritem)->value;
+
+   return (l > r) - (l < r);
+} /* intcmp */
+
+/* 1------------------1 */
+
+static unsigned long strhash(void *item)
+{
+   return hshmemhash(((bitemptr)item)->key, ((bitemptr)item)->len);
+} /* strhash */
+
+/* 1------------------1 */
+
+static unsigned long strrehash(void *item)
+{
+   return hshmemrehash(((bitemptr)item)->key, ((bitemptr)item)->len);
+} /* strrehash */
+
+/* 1------------------1 */
+
+static int strkeycmp(void *litem, void *ritem)
+{
+   bitemptr l = litem, r = ritem;
+
+   if (l->len != r->len) return (l->len > r->len) ? 1 : -1;
+   return memcmp(l->key, r->key, l->len);
+} /* strkeycmp */
+
+/* 1------------------1 */
+
+static void *bdupe(void *item)
+{
+   bitemptr b;
+
+   if ((b = malloc(sizeof *b))) *b = *(bitemptr)item;
+   return b;
+} /* bdupe */
+
+/* 1------------------1 */
+
+static void bundupe(void *item)
+{
+   free(item);
+} /* bundupe */
+
+/* 1------------------1 */
+
+static void *barenadupe(void *item, hshtbl *master)
+{
+   bitemptr b;
+
+   if ((b = hshaalloc(master, sizeof *b))) *b = *(bitemptr)item;
+   return b;
+} /* barenadupe */
+
+/* 1------------------1 */
+
+static int bcount(void *item, void *datum, void *xtra)
+{
+   (void)item; (void)xtra;
+   ++*(unsigned long *)datum;
+   return 0;
+} /* bcount */
+
+/* 1------------------1 */
+
+static double now(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec * 1e-9;
+} /* now */
+
+/* 1------------------1 */
+
+static int cmpdouble(const void *l, const void *r)
+{
+   double a = *(const double *)l, b = *(const double *)r;
+
+   return (a > b) - (a < b);
+} /* cmpdouble */
+
+/* 1------------------1 */
+
+/* The smallest of many back to back clock readings, in ns */
+static double clockcost(void)
+{
+   double t0, t1, least;
+   int    i;
+
+   least = 1e9;
+   for (i = 0; i < 100000; i++) {
+      t0 = now();
+      t1 = now();
+      if ((t1 - t0) * 1e9 < least) least = (t1 - t0) * 1e9;
+   }
+   return least;
+} /* clockcost */
+
+/* 1------------------1 */
+
+/* A bijection on 32 bits, so different i give different keys */
+static unsigned long scramble(unsigned long i, unsigned long seed)
+{
+   unsigned long v;
+
+   v = ((i ^ seed) * 2654435761UL) & 0xffffffffUL;
+   v = ((v ^ (v >> 16)) * 0x45d9f3bUL) & 0xffffffffUL;
+   return v ^ (v >> 16);
+} /* scramble */
+
+/* 1------------------1 */
+
+/* Make count different keys.  A str key is the hex digits of */
+/* its scrambled index then letters from g on, 6 to 14 long.  */
+static void makekeys(bitemptr keys, unsigned long count, int str,
+                     unsigned long seed)
+{
+   unsigned long i;
+   size_t        j, len;
+
+   for (i = 0; i < count; i++) {
+      keys[i].value = scramble(i, seed);
+      if (str) {
+         len = 6 + randomMT() % 9;
+         j = sprintf(keys[i].key, "%lx", keys[i].value);
+         while (j < len) keys[i].key[j++] = 'g' + randomMT() % 20;
+         keys[i].key[j] = '\0';
+         keys[i].len = j;
+      }
+      else {
+         keys[i].len = 0;
+         keys[i].key[0] = '\0';
+      }
+   }
+} /* makekeys */
+
+/* 1------------------1 */
+
+/* One operation on keys[idx[i]] or, for MISS, keys[n + i] */
+static void op(int which, hshtbl *h, bitemptr keys,
+               unsigned long *idx, unsigned long n, unsigned long i)
+{
+   void *p;
+
+   switch (which) {
+case INSERT: hshinsert(h, &keys[i]); break;
+case HIT:    hshfind(h, &keys[idx[i]]); break;
+case MISS:   hshfind(h, &keys[n + i]); break;
+case DELETE: if ((p = hshdelete(h, &keys[idx[i]])) && !inarena)
+                bundupe(p);
+             break;
+   }
+} /* op */
+
+/* 1------------------1 */
+
+/* Build a table of n keys and take it apart again, rounds    */
+/* times, adding to ph.  When timing, every stride-th single  */
+/* operation is timed instead of the passes as a whole.       */
+/* Returns 0, or 1 if the table went wrong.                   */
+static int rounds(phase *ph, hshfn hash, hshfn rehash, hshcmpfn cmp,
+                  const hshopts *opts, bitemptr keys,
+                  unsigned long *idx, unsigned long n,
+                  unsigned long nrounds, int timing,
+                  unsigned long stride)
+{
+   hshtbl        *h;
+   unsigned long  r, i, walked, k;
+   int            which, bad;
+   double         t0, t1;
+   void          *p;
+
+   bad = 0;
+   for (k = r = 0; r < nrounds; r++) {
+      if (!(h = hshinitopts(hash, rehash, cmp, bdupe, bundupe,
+                            0, opts)))
+         return 1;
+      for (which = INSERT; which < PHASES; which++) {
+         if (WALK == which) {
+            walked = 0;
+            t0 = now();
+            hshwalk(h, bcount, &walked);
+            t1 = now();
+            if (walked != n) bad = 1;
+            if (!timing) {
+               ph[WALK].seconds += t1 - t0;
+               ph[WALK].ops += n;
+            }
+            continue;
+         }
+         if (timing) {
+            for (i = 0; i < n; i++, k++) {
+               if ((k % stride) || (ph[which].nlat >= MAXSAMPLES)) {
+                  op(which, h, keys, idx, n, i);
+                  continue;
+               }
+               t0 = now();
+               op(which, h, keys, idx, n, i);
+               t1 = now();
+               ph[which].lat[ph[which].nlat++] =
+                  (t1 - t0) * 1e9 - overhead;
+            }
+         }
+         else {
+            t0 = now();
+            switch (which) {  /* no op() call in the way */
+case INSERT:   for (i = 0; i < n; i++) hshinsert(h, &keys[i]);
+               break;
+case HIT:      for (i = 0; i < n; i++)
+                  if (!hshfind(h, &keys[idx[i]])) bad = 1;
+               break;
+case MISS:     for (i = 0; i < n; i++)
+                  if (hshfind(h, &keys[n + i])) bad = 1;
+               break;
+case DELETE:   for (i = 0; i < n; i++)
+                  if ((p = hshdelete(h, &keys[idx[i]])) && !inarena)
+                     bundupe(p);
+               break;
+            }
+            t1 = now();
+            ph[which].seconds += t1 - t0;
+            ph[which].ops += n;
+         }
+      }
+      hshkill(h);
+   }
+   return bad;
+} /* rounds */
+
+/* 1------------------1 */
+
+static void usage(void)
+{
+   fputs("Usage: hshbench [-k int|str] [-m mode] [-a] [-f from]"
+         " [-t to] [-s seed]\n"
+         "  Times insert, hit, miss, delete and walk on tables of\n"
+         "  10^from to 10^to keys, default 2 to 6, as JSON.\n",
+         stderr);
+   fputs("  mode is default, incremental, swiss, robin or small,\n"
+         "  -a adds the arena mode.\n", stderr);
+} /* usage */
+
+/* 1------------------1 */
+
+int main(int argc, char **argv)
+{
+   static const char *modename[] =
+      {"default", "incremental", "swiss", "robin", "small"};
+   static const unsigned int modeflag[] =
+      {hshDEFAULT, hshINCREMENTAL, hshSWISS, hshROBIN, hshSMALL};
+   static const double qs[3] = {0.5, 0.99, 0.999};
+   static const char  *qname[3] = {"50", "99", "999"};
+   hshopts        opts;
+   hshtbl        *h;
+   phase          ph[PHASES];
+   bitemptr       keys;
+   unsigned long *idx, n, i, j, t, nrounds, stride, seed;
+   int            str, mode, arena, from, to, e, a, which, bad;
+   unsigned long  at;
+
+   str = arena = 0;
+   mode = 0;
+   from = 2; to = 6;
+   seed = 4357;
+   for (a = 1; a < argc; a++) {
+      if (!strcmp(argv[a], "-a")) arena = 1;
+      else if (a + 1 >= argc) break;
+      else if (!strcmp(argv[a], "-k")) str = !strcmp(argv[++a], "str");
+      else if (!strcmp(argv[a], "-f")) from = atoi(argv[++a]);
+      else if (!strcmp(argv[a], "-t")) to = atoi(argv[++a]);
+      else if (!strcmp(argv[a], "-s"))
+         seed = strtoul(argv[++a], NULL, 0);
+      else if (!strcmp(argv[a], "-m")) {
+         for (++a, mode = 0; mode < 5; mode++)
+            if (!strcmp(argv[a], modename[mode])) break;
+         if (5 == mode) break;
+      }
+      else break;
+   }
+   if ((a < argc) || (from < 1) || (to < from) || (to > 9)) {
+      usage();
+      return EXIT_FAILURE;
+   }
+   for (n = 1, e = 0; e < to; e++) n *= 10;
+   if (n > (size_t)-1 / 2 / sizeof *keys) {
+      fputs("Too many keys for this machine\n", stderr);
+      return EXIT_FAILURE;
+   }
+   keys = malloc(2 * n * sizeof *keys);
+   idx = malloc(n * sizeof *idx);
+   bad = !keys || !idx;
+   for (which = 0; which < PHASES; which++)
+      if (!(ph[which].lat = malloc(MAXSAMPLES * sizeof *ph[which].lat)))
+         bad = 1;
+   if (bad) {
+      fputs("No memory\n", stderr);
+      return EXIT_FAILURE;
+   }
+   seedMT(seed);
+   makekeys(keys, 2 * n, str, seed);
+   opts.mode = modeflag[mode] | (arena ? hshARENA : 0);
+   opts.reserve = 0;
+   opts.adupe = arena ? barenadupe : NULL;
+   inarena = arena;
+   overhead = clockcost();
+   if (!(h = hshinitopts(str ? strhash : inthash,
+                         str ? strrehash : intrehash,
+                         str ? strkeycmp : intcmp,
+                         bdupe, bundupe, 0, &opts))) {
+      fputs("No table\n", stderr);
+      return EXIT_FAILURE;
+   }
+
+   printf("{\n");
+   printf("  \"hashlib_version\": %u,\n", hshstatus(h).version);
+   printf("  \"keys\": \"%s\",\n", str ? "str" : "int");
+   printf("  \"mode\": \"%s\",\n", modename[mode]);
+   printf("  \"arena\": %s,\n", arena ? "true" : "false");
+   printf("  \"seed\": %lu,\n", seed);
+   printf("  \"clock_ns\": %.1f,\n", overhead);
+   printf("  \"sizes\": [");
+   hshkill(h);
+
+   for (n = 1, e = 0; e < from; e++) n *= 10;
+   for (e = from; e <= to; e++, n *= 10) {
+      for (i = 0; i < n; i++) idx[i] = i;
+      for (i = n - 1; i > 0; i--) {   /* shuffle */
+         j = randomMT() % (i + 1);
+         t = idx[i]; idx[i] = idx[j]; idx[j] = t;
+      }
+      nrounds = (n < MINOPS) ? MINOPS / n : 1;
+      stride = (n * nrounds + MAXSAMPLES - 1) / MAXSAMPLES;
+      for (which = 0; which < PHASES; which++) {
+         ph[which].seconds = 0;
+         ph[which].ops = ph[which].nlat = 0;
+      }
+      bad = rounds(ph, str ? strhash : inthash,
+                   str ? strrehash : intrehash,
+                   str ? strkeycmp : intcmp,
+                   &opts, keys, idx, n, nrounds, 0, 1);
+      bad |= rounds(ph, str ? strhash : inthash,
+                    str ? strrehash : intrehash,
+                    str ? strkeycmp : intcmp,
+                    &opts, keys, idx, n, nrounds, 1, stride);
+
+      printf("%s\n    {\"n\": %lu, \"rounds\": %lu, \"ok\": %s",
+             (e == from) ? "" : ",", n, nrounds, bad ? "false" : "true");
+      for (which = 0; which < PHASES; which++) {
+         printf(",\n     \"%s\": {\"ns_per_op\": %.2f, \"mops\": %.3f",
+                phasename[which],
+                1e9 * ph[which].seconds / ph[which].ops,
+                ph[which].ops / ph[which].seconds / 1e6);
+         if (ph[which].nlat) {
+            qsort(ph[which].lat, ph[which].nlat, sizeof (double),
+                  cmpdouble);
+            for (a = 0; a < 3; a++) {
+               at = (unsigned long)(qs[a] * (ph[which].nlat - 1));
+               printf(", \"p%s_ns\": %.1f", qname[a],
+                      (ph[which].lat[at] > 0) ? ph[which].lat[at] : 0.0);
+            }
+         }
+         printf("}");
+      }
+      printf("}");
+      fflush(stdout);
+   }
+   printf("\n  ]\n}\n");
+   for (which = 0; which < PHASES; which++) free(ph[which].lat);
+   free(idx);
+   free(keys);
+   return 0;
+} /* main */
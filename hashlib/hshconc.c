@@ -0,0 +1,281 @@
+/* -------------- File hshconc.c ------------------ */
+/* Sharded hashlib tables, for several threads at once.
+   See hshconc.h for the interface.
+
+   v 1.0.0.0 2026-10-18 First version
+   v 1.0.0.1 2026-10-18 Added hshwalkpar
+*/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>
+#include <pthread.h>
+#include "hashlib.h"
+#include "hshconc.h"
+
+#define DEFSHARDS 16
+#define MAXSHARDS 1024
+#define CACHELINE 64
+#define MAXWALKERS 256
+
+/* One shard.  The padding keeps the locks of neighbouring  */
+/* shards off each others cache line.                       */
+typedef struct hshshard {
+   pthread_rwlock_t  lock;
+   hshtbl           *tbl;
+   char              pad[CACHELINE];
+} hshshard;
+
+struct hshconctag {
+   hshshard     *shard;    /* count of them */
+   unsigned int  count;    /* a power of 2 */
+   hshfn         hash;
+};
+
+/* 1------------------1 */
+
+/* The shard for item.  The hash is mixed again, so that */
+/* the bits picking the shard are not those the shard    */
+/* itself uses to place the item.                        */
+static hshshard *route(hshconc *table, void *item)
+{
+   unsigned long h;
+
+   h = table->hash(item);
+   h ^= h >> 16;
+   h = (h * 0x45d9f3bUL) & 0xffffffffUL;
+   h ^= h >> 16;
+   return &table->shard[h & (table->count - 1)];
+} /* route */
+
+/* 1------------------1 */
+
+/* initialize and return a pointer to a sharded table */
+hshconc *hshconcinit(hshfn    hash, hshfn     rehash,
+                     hshcmpfn cmp,
+                     hshdupfn dupe, hshfreefn undupe,
+                     int      hdebug,
+                     const hshopts *opts,
+                     unsigned int shards)
+{
+   hshconc      *table;
+   hshopts       each;
+   unsigned int  n, i;
+
+   if (!shards) shards = DEFSHARDS;
+   if (shards > MAXSHARDS) shards = MAXSHARDS;
+   for (n = 1; n < shards; n <<= 1) continue;
+   if (opts) each = *opts;
+   else {
+      each.mode = hshDEFAULT;
+      each.reserve = 0;
+      each.adupe = NULL;
+   }
+   if (each.reserve) each.reserve = each.reserve / n + 1;
+
+   if (!hash || !(table = malloc(sizeof *table))) return NULL;
+   if (!(table->shard = malloc(n * sizeof *table->shard))) {
+      free(table);
+      return NULL;
+   }
+   table->count = 0;
+   table->hash = hash;
+   for (i = 0; i < n; i++) {
+      if (!(table->shard[i].tbl = hshinitopts(hash, rehash, cmp,
+                                              dupe, undupe,
+                                              hdebug, &each)))
+         break;
+      if (pthread_rwlock_init(&table->shard[i].lock, NULL)) {
+         hshkill(table->shard[i].tbl);
+         break;
+      }
+      table->count++;
+   }
+   if (table->count < n) {
+      hshconckill(table);
+      return NULL;
+   }
+   return table;
+} /* hshconcinit */
+
+/* 1------------------1 */
+
+/* destroy the table */
+void hshconckill(hshconc *table)
+{
+   unsigned int i;
+
+   if (table) {
+      for (i = 0; i < table->count; i++) {
+         hshkill(table->shard[i].tbl);
+         pthread_rwlock_destroy(&table->shard[i].lock);
+      }
+      free(table->shard);
+      free(table);
+   }
+} /* hshconckill */
+
+/* 1------------------1 */
+
+/* insert an entry.  NULL == failure, else item */
+void * hshconcinsert(hshconc *table, void *item)
+{
+   hshshard *s;
+   void     *stored;
+
+   s = route(table, item);
+   pthread_rwlock_wrlock(&s->lock);
+   stored = hshinsert(s->tbl, item);
+   pthread_rwlock_unlock(&s->lock);
+   return stored;
+} /* hshconcinsert */
+
+/* 1------------------1 */
+
+/* insert if absent, then exec the stored item under lock */
+void * hshconcapply(hshconc *table, void *item,
+                    hshexecfn exec, void *datum)
+{
+   hshshard *s;
+   void     *stored;
+
+   s = route(table, item);
+   pthread_rwlock_wrlock(&s->lock);
+   if ((stored = hshinsert(s->tbl, item)) && exec)
+      (void) exec(stored, datum, NULL);
+   pthread_rwlock_unlock(&s->lock);
+   return stored;
+} /* hshconcapply */
+
+/* 1------------------1 */
+
+/* find an existing entry. NULL == notfound */
+/* hshlookup writes nothing in the shard,   */
+/* so a read lock is enough.                */
+void * hshconcfind(hshconc *table, void *item)
+{
+   hshshard *s;
+   void     *stored;
+
+   s = route(table, item);
+   pthread_rwlock_rdlock(&s->lock);
+   stored = hshlookup(s->tbl, item, NULL);
+   pthread_rwlock_unlock(&s->lock);
+   return stored;
+} /* hshconcfind */
+
+/* 1------------------1 */
+
+/* delete an existing entry. NULL == notfound */
+void * hshconcdelete(hshconc *table, void *item)
+{
+   hshshard *s;
+   void     *olditem;
+
+   s = route(table, item);
+   pthread_rwlock_wrlock(&s->lock);
+   olditem = hshdelete(s->tbl, item);
+   pthread_rwlock_unlock(&s->lock);
+   return olditem;
+} /* hshconcdelete */
+
+/* 1------------------1 */
+
+/* apply exec() to all entries, shard by shard */
+int hshconcwalk(hshconc *table, hshexecfn exec, void *datum)
+{
+   unsigned int i;
+   int          err;
+
+   for (err = 0, i = 0; !err && (i < table->count); i++) {
+      pthread_rwlock_rdlock(&table->shard[i].lock);
+      err = hshwalk(table->shard[i].tbl, exec, datum);
+      pthread_rwlock_unlock(&table->shard[i].lock);
+   }
+   return err;
+} /* hshconcwalk */
+
+/* 1------------------1 */
+
+/* return the statistics of all shards together */
+hshstats hshconcstatus(hshconc *table)
+{
+   hshstats     total, st;
+   unsigned int i;
+
+   total.probes = total.misses = 0;
+   total.hentries = total.hdeleted = 0;
+   total.herror = hshOK;
+   total.version = 0;
+   for (i = 0; i < table->count; i++) {
+      pthread_rwlock_rdlock(&table->shard[i].lock);
+      st = hshstatus(table->shard[i].tbl);
+      pthread_rwlock_unlock(&table->shard[i].lock);
+      total.probes += st.probes;
+      total.misses += st.misses;
+      total.hentries += st.hentries;
+      total.hdeleted += st.hdeleted;
+      total.herror = (enum hsherr)(total.herror | st.herror);
+      total.version = st.version;
+   }
+   return total;
+} /* hshconcstatus */
+
+/* 1------------------1 */
+
+/* The work of one thread of hshwalkpar */
+typedef struct walker {
+   hshtbl        *tbl;
+   unsigned long  part, parts;
+   hshexecfn      exec;
+   void          *datum;
+   int            err;
+} walker;
+
+/* 1------------------1 */
+
+static void *walkpart(void *arg)
+{
+   walker *w = arg;
+
+   w->err = hshwalkrange(w->tbl, w->part, w->parts, w->exec, w->datum);
+   return NULL;
+} /* walkpart */
+
+/* 1------------------1 */
+
+/* walk table with several threads, each over a part */
+int hshwalkpar(hshtbl *table, unsigned int threads,
+               hshexecfn exec, void *data, size_t size,
+               hshreducefn reduce)
+{
+   walker        w[MAXWALKERS];
+   pthread_t     tid[MAXWALKERS];
+   int           started[MAXWALKERS];
+   unsigned int  i;
+   int           err;
+
+   if (!exec || !data || !threads || (threads > MAXWALKERS)) return -1;
+   for (i = 0; i < threads; i++) {
+      w[i].tbl = table;
+      w[i].part = i;
+      w[i].parts = threads;
+      w[i].exec = exec;
+      w[i].datum = (char *)data + i * size;
+      w[i].err = 0;
+   }
+   /* the calling thread takes part 0 itself */
+   for (i = 1; i < threads; i++)
+      started[i] = !pthread_create(&tid[i], NULL, walkpart, &w[i]);
+   walkpart(&w[0]);
+   for (i = 1; i < threads; i++) {
+      if (started[i]) pthread_join(tid[i], NULL);
+      else walkpart(&w[i]);
+   }
+   for (err = 0, i = 0; i < threads; i++) {
+      if (!err) err = w[i].err;
+      if (reduce && i) reduce(data, w[i].datum);
+   }
+   return err;
+} /* hshwalkpar */
+/* -------------- File hshconc.c ------------------ */
@@ -0,0 +1,131 @@
+/* -------------- File hshconc.h ------------------ */
+#ifndef hshconc_h
+#define hshconc_h
+
+#include "hashlib.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Sharded hashlib tables, for several threads at once.
+
+   A hshconc table is a number of ordinary hashlib tables, the
+   shards, each with its own read/write lock.  Every item goes
+   to the shard picked by bits of its hash, so threads working
+   on different items rarely wait for each other, and inserts
+   scale with the number of threads where one table behind one
+   lock would not.  Finds only take the lock for reading, and
+   any number of them proceed together on the same shard.
+
+   The hash function is called once to pick the shard, and then
+   again by the shard itself.  All the auxiliary functions may
+   be called by several threads at once, for different items.
+
+   hshwalkpar walks an ordinary hashlib table with several
+   threads, each over its own part of the slots.
+
+   Needs POSIX threads.  Link with -lpthread.
+
+   v 1.0.0.0 2026-10-18 First version, on hashlib 1.0.1.1
+   v 1.0.0.1 2026-10-18 Added hshwalkpar, on hashlib 1.0.1.3
+*/
+
+typedef struct hshconctag hshconc;
+
+/* 1------------------1 */
+
+/* initialize and return a pointer to a sharded table.  The  */
+/* arguments up to opts are those of hshinitopts, and apply  */
+/* to every shard.  opts->reserve is divided between them.   */
+/* shards is rounded up to a power of 2, at most 1024, and 0 */
+/* gives 16.  A few times the number of threads is plenty.   */
+/* NULL on failure.                                          */
+hshconc *hshconcinit(hshfn    hash, hshfn     rehash,
+                     hshcmpfn cmp,
+                     hshdupfn dupe, hshfreefn undupe,
+                     int      hdebug,
+                     const hshopts *opts,
+                     unsigned int shards);
+
+/* 1------------------1 */
+
+/* destroy the table.  Accepts NULL.  No other thread may be */
+/* using it.                                                 */
+void     hshconckill(hshconc *table);
+
+/* 1------------------1 */
+
+/* insert an entry.  NULL == failure, else item, as for      */
+/* hshinsert.  The stored item may be used after return, but */
+/* changes to it must be left to hshconcapply, unless the    */
+/* application coordinates them itself.                      */
+void *   hshconcinsert(hshconc *table, void *item);
+
+/* 1------------------1 */
+
+/* insert item if absent, then call exec(stored, datum, NULL) */
+/* with the shard locked, so that exec may safely update the  */
+/* stored item, such as counting it.  exec must not call any  */
+/* hshconc function on this table.  Returns the stored item,  */
+/* NULL on failure, when exec is not called.                  */
+void *   hshconcapply(hshconc *table, void *item,
+                      hshexecfn exec, void *datum);
+
+/* 1------------------1 */
+
+/* find an existing entry.  NULL == notfound.  The probes of */
+/* a find are not counted in the statistics.                 */
+void *   hshconcfind(hshconc *table, void *item);
+
+/* 1------------------1 */
+
+/* delete an existing entry.  NULL == notfound, as for      */
+/* hshdelete.  No other thread may still be using the item. */
+void *   hshconcdelete(hshconc *table, void *item);
+
+/* 1------------------1 */
+
+/* apply exec to all entries in all shards, one shard after */
+/* another, each locked for reading while it is walked.     */
+/* Returns 0, or the non-zero value from exec that stopped  */
+/* the walk.  exec must not call any hshconc function that  */
+/* changes this table.                                      */
+int      hshconcwalk(hshconc *table, hshexecfn exec, void *datum);
+
+/* 1------------------1 */
+
+/* return the statistics of all the shards added together, */
+/* with the herror values or'ed.                           */
+hshstats hshconcstatus(hshconc *table);
+
+/* 1------------------1 */
+
+/* A hshreducefn() combines the datum from of one thread of */
+/* hshwalkpar into the datum into of another.               */
+typedef void (*hshreducefn)(void *into, void *from);
+
+/* walk the ordinary table with threads threads, thread k   */
+/* calling exec on the entries of part k of the slots, by   */
+/* hshwalkrange, with the datum at data + k * size.  data   */
+/* thus holds threads datums of size bytes, set up by the   */
+/* caller.  When all are done reduce, unless NULL, combines */
+/* datums 1 up to threads - 1 in turn into datum 0.  A      */
+/* thread is stopped by a non-zero value from exec, but the */
+/* others carry on, and the first such value in order of    */
+/* the parts is returned, else 0.  exec is called by        */
+/* several threads at once, and nothing may change table   */
+/* meanwhile.  If a thread cannot be started, its part is   */
+/* walked by the calling thread.  Pad size to a multiple of */
+/* the cache line, usually 64 bytes, so that no two threads */
+/* write to the same line, which would slow them all down.  */
+int      hshwalkpar(hshtbl *table, unsigned int threads,
+                    hshexecfn exec, void *data, size_t size,
+                    hshreducefn reduce);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
+/* -------------- File hshconc.h ------------------ */
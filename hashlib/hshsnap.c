@@ -0,0 +1,374 @@
+/* -------------- File hshsnap.c ------------------ */
+/* Snapshots of hashlib tables, reopened read-only with mmap.
+   See hshsnap.h for the interface.
+
+   The file holds a header, then the item images, each at an
+   aligned offset, then the slot array.  The slots are a power
+   of 2 in number, at least twice the items, and each holds the
+   file offset of an image, 0 for an empty slot, and its hash.
+   An image is placed by linear probing from its mixed hash, so
+   a search reads consecutive slots, mostly from one cache line,
+   and looks at an image only when its hash matches.
+
+   v 1.0.0.0 2026-10-18 First version
+   v 1.0.0.1 2026-10-18 A slot that points outside the images,
+                        as in a damaged file, ends the search
+   v 1.0.0.2 2026-10-18 The save writes a new file and renames it
+                        over the old, which stays intact for any
+                        process that still has it mapped
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include "hashlib.h"
+#include "hshsnap.h"
+
+#define SNAPVER   1002      /* 1.0.0.2 */
+#define FORMAT    1000      /* of the file, 1.0.0.0 */
+#define SNAPMAGIC "HSHSNAP"
+#define BYTEORDER 0x01020304UL
+
+#if ULONG_MAX > 4294967295UL
+#  define GOLDEN   0x9e3779b97f4a7c15UL
+#  define HALFBITS 32
+#else
+#  define GOLDEN   0x9e3779b9UL
+#  define HALFBITS 16
+#endif
+
+/* The alignment of the images */
+typedef union snapalign {
+   long    l;
+   double  d;
+   void   *p;
+} snapalign;
+
+#define ALIGNSZ   sizeof(snapalign)
+#define ROUNDUP(n) (((n) + ALIGNSZ - 1) / ALIGNSZ * ALIGNSZ)
+
+/* The start of the file */
+typedef struct snaphdr {
+   char           magic[8];
+   unsigned long  byteorder;   /* BYTEORDER as written */
+   unsigned int   longsize;    /* sizeof(unsigned long) */
+   unsigned int   format;      /* FORMAT */
+   unsigned long  size;        /* slots, a power of 2 */
+   unsigned long  entries;     /* images */
+   unsigned long  slotsat;     /* file offset of the slots */
+   unsigned long  length;      /* of the whole file */
+} snaphdr;
+
+typedef struct snapslot {
+   unsigned long  at;          /* file offset of image, 0 empty */
+   unsigned long  hash;
+} snapslot;
+
+struct hshsnaptag {
+   char          *base;        /* the mapped file */
+   size_t         length;
+   snapslot      *slots;
+   unsigned long  mask;        /* size - 1 */
+   unsigned long  slotsat;     /* the images lie below this */
+   hshfn          hash;
+   hshcmpfn       cmp;
+   hshstats       hstatus;
+};
+
+/* 1------------------1 */
+
+/* The hash of an item mixed, the high bits giving its home */
+static unsigned long snapmix(unsigned long hash)
+{
+   hash *= GOLDEN;
+   return hash ^ (hash >> HALFBITS);
+} /* snapmix */
+
+/* 1------------------1 */
+
+/* The errno of a failed call, EIO if it did not set one, */
+/* as fwrite need not.                                    */
+static int failure(void)
+{
+   return errno ? errno : EIO;
+} /* failure */
+
+/* 1------------------1 */
+
+/* What hshsnapsave keeps while walking the table */
+typedef struct saving {
+   FILE          *fp;
+   hshfn          hash;
+   hshflatfn      flat;
+   char          *buf;         /* room bytes, for one image */
+   size_t         room;
+   unsigned long  at;          /* file offset of the next image */
+   snapslot      *found;       /* of count, one per image */
+   unsigned long  count, max;
+   int            err;         /* errno of a failure */
+} saving;
+
+/* 1------------------1 */
+
+/* hshwalk function of hshsnapsave, writing one image */
+static int saveone(void *item, void *datum, void *xtra)
+{
+   saving *s = datum;
+   size_t  len;
+   char   *more;
+
+   (void)xtra;
+   if (s->count == s->max) {
+      s->err = EINVAL;          /* the table changed */
+      return 1;
+   }
+   if ((len = s->flat(item, s->buf, s->room)) > s->room) {
+      if (!(more = realloc(s->buf, ROUNDUP(len)))) {
+         s->err = ENOMEM;
+         return 1;
+      }
+      memset(more, 0, ROUNDUP(len));
+      s->buf = more;
+      s->room = ROUNDUP(len);
+      len = s->flat(item, s->buf, s->room);
+   }
+   if (!len || (len > s->room)) {
+      s->err = EINVAL;
+      return 1;
+   }
+   if (1 != fwrite(s->buf, ROUNDUP(len), 1, s->fp)) {
+      s->err = failure();
+      return 1;
+   }
+   memset(s->buf, 0, ROUNDUP(len));  /* no stray bytes in the file */
+   s->found[s->count].at = s->at;
+   s->found[s->count].hash = s->hash(item);
+   s->count++;
+   s->at += ROUNDUP(len);
+   return 0;
+} /* saveone */
+
+/* 1------------------1 */
+
+/* write the items of table to path, by way of a new file */
+/* in the same directory renamed over it when complete     */
+int hshsnapsave(hshtbl *table, const char *path,
+                hshfn hash, hshflatfn flat)
+{
+   saving         s;
+   snaphdr        hdr;
+   snapslot      *slots;
+   hshstats       st;
+   struct stat    sb;
+   unsigned long  size, i, j;
+   char          *tmp;
+   int            err, fd;
+
+   st = hshstatus(table);
+   s.hash = hash;
+   s.flat = flat;
+   s.max = st.hentries - st.hdeleted;
+   s.count = 0;
+   s.err = 0;
+   s.room = 256;
+   for (size = 16; size && (size < 2 * s.max); size <<= 1) continue;
+   if (!size || (s.max > ULONG_MAX / 2)) {
+      errno = EINVAL;
+      return -1;
+   }
+   s.buf = calloc(s.room, 1);
+   s.found = malloc((s.max ? s.max : 1) * sizeof *s.found);
+   slots = calloc(size, sizeof *slots);
+   tmp = malloc(strlen(path) + sizeof ".XXXXXX");
+   if (!s.buf || !s.found || !slots || !tmp) {
+      free(s.buf); free(s.found); free(slots); free(tmp);
+      errno = ENOMEM;
+      return -1;
+   }
+   strcat(strcpy(tmp, path), ".XXXXXX");
+   errno = 0;
+   if ((fd = mkstemp(tmp)) < 0) err = failure();
+   else if (fchmod(fd, stat(path, &sb) ? 0644 : sb.st_mode & 07777)
+            || !(s.fp = fdopen(fd, "wb"))) {
+      err = failure();
+      close(fd);
+      remove(tmp);
+   }
+   else {
+      memset(&hdr, 0, sizeof hdr);
+      s.at = ROUNDUP(sizeof hdr);
+      if ((1 != fwrite(&hdr, sizeof hdr, 1, s.fp))
+          || fseek(s.fp, (long)s.at, SEEK_SET))
+         err = failure();
+      else if (hshwalk(table, saveone, &s)) err = s.err;
+      else {
+         for (j = 0; j < s.count; j++) {
+            i = snapmix(s.found[j].hash) & (size - 1);
+            while (slots[i].at) i = (i + 1) & (size - 1);
+            slots[i] = s.found[j];
+         }
+         memcpy(hdr.magic, SNAPMAGIC, sizeof SNAPMAGIC);
+         hdr.byteorder = BYTEORDER;
+         hdr.longsize = sizeof(unsigned long);
+         hdr.format = FORMAT;
+         hdr.size = size;
+         hdr.entries = s.count;
+         hdr.slotsat = s.at;
+         hdr.length = s.at + size * sizeof *slots;
+         if ((size != fwrite(slots, sizeof *slots, size, s.fp))
+             || fseek(s.fp, 0L, SEEK_SET)
+             || (1 != fwrite(&hdr, sizeof hdr, 1, s.fp))
+             || fflush(s.fp) || fsync(fd))
+            err = failure();
+         else err = 0;
+      }
+      if (fclose(s.fp) && !err) err = failure();
+      /* the old file stays whole for those who have it mapped */
+      if (!err && rename(tmp, path)) err = failure();
+      if (err) remove(tmp);
+   }
+   free(s.buf); free(s.found); free(slots); free(tmp);
+   if (err) {
+      errno = err;
+      return -1;
+   }
+   return 0;
+} /* hshsnapsave */
+
+/* 1------------------1 */
+
+/* map the snapshot in path */
+hshsnap *hshsnapopen(const char *path, hshfn hash, hshcmpfn cmp)
+{
+   hshsnap     *snap;
+   snaphdr      hdr;
+   struct stat  sb;
+   void        *base;
+   int          fd, err;
+
+   if ((fd = open(path, O_RDONLY)) < 0) return NULL;
+   if (fstat(fd, &sb)) err = errno;
+   else if (((size_t)sb.st_size < sizeof hdr)
+            || ((ssize_t)sizeof hdr != read(fd, &hdr, sizeof hdr))
+            || memcmp(hdr.magic, SNAPMAGIC, sizeof SNAPMAGIC)
+            || (BYTEORDER != hdr.byteorder)
+            || (sizeof(unsigned long) != hdr.longsize)
+            || (FORMAT != hdr.format)
+            || (hdr.length != (unsigned long)sb.st_size)
+            || !hdr.size || (hdr.size & (hdr.size - 1))
+            || (hdr.slotsat % ALIGNSZ)
+            || (hdr.slotsat < ROUNDUP(sizeof hdr))
+            || (hdr.slotsat > hdr.length)
+            || ((hdr.length - hdr.slotsat) / sizeof(snapslot)
+                != hdr.size))
+      err = EINVAL;
+   else if (MAP_FAILED == (base = mmap(NULL, hdr.length, PROT_READ,
+                                       MAP_SHARED, fd, 0)))
+      err = errno;
+   else if (!(snap = malloc(sizeof *snap))) {
+      munmap(base, hdr.length);
+      err = ENOMEM;
+   }
+   else {
+      close(fd);   /* the mapping stays */
+      snap->base = base;
+      snap->length = hdr.length;
+      snap->slots = (snapslot *)(snap->base + hdr.slotsat);
+      snap->mask = hdr.size - 1;
+      snap->slotsat = hdr.slotsat;
+      snap->hash = hash;
+      snap->cmp = cmp;
+      snap->hstatus.probes = snap->hstatus.misses = 0;
+      snap->hstatus.hentries = hdr.entries;
+      snap->hstatus.hdeleted = 0;
+      snap->hstatus.herror = hshOK;
+      snap->hstatus.version = SNAPVER;
+      return snap;
+   }
+   close(fd);
+   errno = err;
+   return NULL;
+} /* hshsnapopen */
+
+/* 1------------------1 */
+
+/* An image offset read from a slot lies among the images, */
+/* so a damaged file cannot send a search outside the map  */
+static int goodimage(hshsnap *snap, unsigned long at)
+{
+   return (at >= ROUNDUP(sizeof(snaphdr))) && (at < snap->slotsat)
+          && !(at % ALIGNSZ);
+} /* goodimage */
+
+/* 1------------------1 */
+
+/* unmap the snapshot */
+void hshsnapclose(hshsnap *snap)
+{
+   if (snap) {
+      munmap(snap->base, snap->length);
+      free(snap);
+   }
+} /* hshsnapclose */
+
+/* 1------------------1 */
+
+/* find the image matching item. NULL == notfound */
+void * hshsnapfind(hshsnap *snap, void *item)
+{
+   unsigned long  h, i, n;
+   snapslot      *sl;
+
+   h = snap->hash(item);
+   i = snapmix(h) & snap->mask;
+   for (n = 0; n <= snap->mask; n++, i = (i + 1) & snap->mask) {
+      snap->hstatus.probes++;
+      sl = &snap->slots[i];
+      if (!sl->at) return NULL;
+      if (!goodimage(snap, sl->at)) break;
+      if ((sl->hash == h) && !snap->cmp(snap->base + sl->at, item))
+         return snap->base + sl->at;
+      snap->hstatus.misses++;
+   }
+   snap->hstatus.herror = hshINTERR;   /* damaged, or no empty slot */
+   return NULL;
+} /* hshsnapfind */
+
+/* 1------------------1 */
+
+/* apply exec() to all images */
+int hshsnapwalk(hshsnap *snap, hshexecfn exec, void *datum)
+{
+   unsigned long i;
+   int           err;
+
+   if (NULL == exec) return -1;
+   for (i = 0; i <= snap->mask; i++)
+      if (snap->slots[i].at) {
+         if (!goodimage(snap, snap->slots[i].at)) {
+            snap->hstatus.herror = hshINTERR;
+            return -1;
+         }
+         if ((err = exec(snap->base + snap->slots[i].at, datum, NULL)))
+            return err;
+      }
+   return 0;
+} /* hshsnapwalk */
+
+/* 1------------------1 */
+
+/* return the statistics of the snapshot */
+hshstats hshsnapstatus(hshsnap *snap)
+{
+   return snap->hstatus;
+} /* hshsnapstatus */
+/* -------------- File hshsnap.c ------------------ */
@@ -0,0 +1,106 @@
+/* -------------- File hshsnap.h ------------------ */
+#ifndef hshsnap_h
+#define hshsnap_h
+
+#include "hashlib.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Snapshots of hashlib tables, reopened read-only with mmap.
+
+   hshsnapsave writes the items of a table to a file, each as a
+   flat image holding no pointers, together with a slot array
+   of their hashes and file offsets.  hshsnapopen maps such a
+   file into memory and searches it where it lies, so a table
+   that took seconds of hshinsert calls to build is ready as
+   soon as the pages it needs are read, usually from the page
+   cache.  Nothing is allocated or copied per item.
+
+   The application supplies a hshflatfn to make the images.  A
+   search hashes the item sought with the same hash function as
+   the save used, and compares it against the images with a
+   cmp function that takes an image as its first argument and
+   the item sought as its second.  Items found, and those seen
+   by a walk, are the images, in memory that may not be written.
+
+   The file is in the byte order and word size of the machine
+   that wrote it, and hshsnapopen refuses any other.
+
+   Needs POSIX mmap.
+
+   v 1.0.0.0 2026-10-18 First version, on hashlib 1.0.1.2
+   v 1.0.0.1 2026-10-18 Searches check the image offsets
+   v 1.0.0.2 2026-10-18 Saves replace the file by a rename
+*/
+
+typedef struct hshsnaptag hshsnap;
+
+/* A hshflatfn() writes a flat image of item into buf, which    */
+/* has room bytes, and returns the length of the image.  Any    */
+/* pointers in item must become something else in the image,   */
+/* such as the offset of the text following it, since it will   */
+/* be found at a different address.  If the image needs more    */
+/* than room bytes, it writes none and just returns the length, */
+/* and is called again with room enough.  0 means failure.      */
+/* An image starts suitably aligned for any type.               */
+typedef size_t (*hshflatfn)(void *item, void *buf, size_t room);
+
+/* 1------------------1 */
+
+/* write the items of table to the file path, replacing it.    */
+/* hash is the hshfn of table, flat makes the item images.     */
+/* The snapshot goes to a new file in the directory of path,   */
+/* which is synced to disk and then renamed to path, so a      */
+/* process that has the old file open with hshsnapopen keeps   */
+/* it whole, and no process ever sees a part written file.     */
+/* The new file takes the permissions of the old, else 0644.   */
+/* Returns 0, else -1 with errno set by the failing call, or   */
+/* EINVAL if flat failed.  The table is not changed.           */
+int      hshsnapsave(hshtbl *table, const char *path,
+                     hshfn hash, hshflatfn flat);
+
+/* 1------------------1 */
+
+/* map the snapshot in the file path.  hash must be the hash   */
+/* function the save used.  cmp(image, item) compares an image */
+/* with the item sought, 0 when they match.  NULL on failure,  */
+/* with errno set, EINVAL when the file is no snapshot of this */
+/* machine.                                                    */
+hshsnap *hshsnapopen(const char *path, hshfn hash, hshcmpfn cmp);
+
+/* 1------------------1 */
+
+/* unmap the snapshot.  Accepts NULL.  The images it gave out */
+/* may no longer be used.                                     */
+void     hshsnapclose(hshsnap *snap);
+
+/* 1------------------1 */
+
+/* find the image matching item.  NULL == notfound.  The image */
+/* is read only.  A slot pointing outside the images, as in a  */
+/* damaged file, gives NULL with herror set to hshINTERR.      */
+void *   hshsnapfind(hshsnap *snap, void *item);
+
+/* 1------------------1 */
+
+/* apply exec to all the images, in no particular order, as   */
+/* hshwalk does.  Returns 0, or the non-zero value from exec  */
+/* that stopped the walk, or -1 with herror set to hshINTERR  */
+/* at a slot pointing outside the images.                     */
+int      hshsnapwalk(hshsnap *snap, hshexecfn exec, void *datum);
+
+/* 1------------------1 */
+
+/* the statistics of the searches made, as hshstatus.        */
+/* hentries is the number of images, hdeleted 0, and version */
+/* that of the snapshot code.                                */
+hshstats hshsnapstatus(hshsnap *snap);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
+/* -------------- File hshsnap.h ------------------ */
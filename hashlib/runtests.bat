@@ -73,12 +73,65 @@ diff -q junk test7.txt
 @if errorlevel 1 goto failure
 @set testcount=9
 
+@echo.
+hashtest 9 >junk
+@if errorlevel 1 goto failure
+diff -q junk test9.txt
+@if errorlevel 1 goto failure
+@set testcount=10
+
+@echo.
+hashtest 10 >junk
+@if errorlevel 1 goto failure
+diff -q junk test10.txt
+@if errorlevel 1 goto failure
+@set testcount=11
+
+@echo.
+hashtest 12 >junk
+@if errorlevel 1 goto failure
+diff -q junk test12.txt
+@if errorlevel 1 goto failure
+@set testcount=12
+
 @echo.
 markov gpl.txt >junk
 @if errorlevel 1 goto failure
 diff -q junk markov.txt
 @if errorlevel 1 goto failure
-@set testcount=10
+@set testcount=13
+
+@echo.
+wdfreq <gpl.txt >junk
+@if errorlevel 1 goto failure
+diff -q junk wdfreq.txt
+@if errorlevel 1 goto failure
+@set testcount=14
+
+:: The listings of the other modes, without their heading lines,
+:: against that read from stdin, and -k 20 against its first 20
+@tail -n +2 wdfreq.txt >junk2
+@echo.
+wdfreq -t 3 gpl.txt >junk
+@if errorlevel 1 goto failure
+tail -n +2 junk | diff -q - junk2
+@if errorlevel 1 goto failure
+@set testcount=15
+
+@echo.
+wdfreq -s 5000 gpl.txt >junk
+@if errorlevel 1 goto failure
+tail -n +3 junk | diff -q - junk2
+@if errorlevel 1 goto failure
+@set testcount=16
+
+@echo.
+wdfreq -k 20 gpl.txt >junk
+@if errorlevel 1 goto failure
+head -n 20 junk2 >junk3
+tail -n +2 junk | diff -q - junk3
+@if errorlevel 1 goto failure
+@set testcount=17
 
 @goto end
 
@@ -0,0 +1,266 @@
+/* Timing test for hshsnap, the mapped table snapshots.
+
+   Usage: snaptest [count [file]]
+
+   Builds a table of count symbols, default 1000000, each a name
+   with a value, by hshinsert, as a program would at every start.
+   Then saves it to file, default snaptest.snp, and times the
+   reopening of the snapshot against that rebuild, and searches
+   of it against searches of the table, for all the names and as
+   many absent ones.  The first pass over the present names of
+   the snapshot is timed apart, as it pays for faulting the pages
+   in, and for reading them when they are not in the page cache.
+   Then it saves a table of one symbol over the file, checks the
+   snapshot still mapped is unharmed, damages a slot of the new
+   file and checks that the walk refuses it.  The file is removed at the end.
+
+   Needs POSIX mmap and clock_gettime.
+*/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "hashlib.h"
+#include "hshsnap.h"
+
+/* A symbol, as the program holds it */
+typedef struct sym {
+   char *name;
+   long  value;
+} sym;
+
+/* A symbol in the snapshot, its name just after */
+typedef struct symimage {
+   long   value;
+   size_t len;
+} symimage;
+
+/* 1------------------1 */
+
+static unsigned long symhash(void *item)
+{
+   return hshmemhash(((sym *)item)->name, strlen(((sym *)item)->name));
+} /* symhash */
+
+/* 1------------------1 */
+
+static unsigned long symrehash(void *item)
+{
+   return hshmemrehash(((sym *)item)->name,
+                       strlen(((sym *)item)->name));
+} /* symrehash */
+
+/* 1------------------1 */
+
+static int symcmp(void *litem, void *ritem)
+{
+   return strcmp(((sym *)litem)->name, ((sym *)ritem)->name);
+} /* symcmp */
+
+/* 1------------------1 */
+
+static void *symdupe(void *item)
+{
+   sym    *s;
+   size_t  len;
+
+   len = strlen(((sym *)item)->name) + 1;
+   if ((s = malloc(sizeof *s + len))) {
+      s->name = memcpy(s + 1, ((sym *)item)->name, len);
+      s->value = ((sym *)item)->value;
+   }
+   return s;
+} /* symdupe */
+
+/* 1------------------1 */
+
+static void symundupe(void *item)
+{
+   free(item);
+} /* symundupe */
+
+/* 1------------------1 */
+
+/* The hshflatfn, the pointer replaced by the text itself */
+static size_t symflat(void *item, void *buf, size_t room)
+{
+   sym      *s = item;
+   symimage *im = buf;
+   size_t    len;
+
+   len = strlen(s->name);
+   if (sizeof *im + len + 1 > room) return sizeof *im + len + 1;
+   im->value = s->value;
+   im->len = len;
+   memcpy(im + 1, s->name, len + 1);
+   return sizeof *im + len + 1;
+} /* symflat */
+
+/* 1------------------1 */
+
+/* Compare an image with the symbol sought */
+static int imagecmp(void *image, void *item)
+{
+   symimage *im = image;
+
+   return strcmp((char *)(im + 1), ((sym *)item)->name);
+} /* imagecmp */
+
+/* 1------------------1 */
+
+static int imagecount(void *image, void *datum, void *xtra)
+{
+   (void)xtra;
+   *(long *)datum += ((symimage *)image)->value;
+   return 0;
+} /* imagecount */
+
+/* 1------------------1 */
+
+static double now(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec * 1e-9;
+} /* now */
+
+/* 1------------------1 */
+
+int main(int argc, char **argv)
+{
+   unsigned long  count, i, v, found;
+   const char    *file;
+   char          *names;
+   sym           *syms, *s;
+   symimage      *im;
+   hshtbl        *h, *h1;
+   hshsnap       *snap;
+   double         t, tbuild, tsave, topen, tfind[2], tsnap[3];
+   long           total;
+   FILE          *fp;
+   int            bad;
+
+   count = (argc > 1) ? strtoul(argv[1], NULL, 0) : 1000000;
+   file = (argc > 2) ? argv[2] : "snaptest.snp";
+   if (!count) {
+      printf("Usage: %s [count [file]]\n", argv[0]);
+      return EXIT_FAILURE;
+   }
+   names = malloc(2 * count * 16);
+   syms = malloc(2 * count * sizeof *syms);
+   if (!names || !syms) {
+      printf("No memory\n");
+      return EXIT_FAILURE;
+   }
+   for (i = 0; i < 2 * count; i++) {  /* scrambled, all different */
+      v = (i * 2654435761UL) & 0xffffffffUL;
+      v = ((v ^ (v >> 16)) * 0x45d9f3bUL) & 0xffffffffUL;
+      syms[i].name = &names[16 * i];
+      sprintf(syms[i].name, "sym_%08lx", v ^ (v >> 16));
+      syms[i].value = (long)(i & 0xff);
+   }
+
+   t = now();
+   h = hshinit(symhash, symrehash, symcmp, symdupe, symundupe, 0);
+   for (i = 0; i < count; i++)
+      if (!hshinsert(h, &syms[i])) break;
+   tbuild = now() - t;
+   if (i < count) {
+      printf("Store failure\n");
+      return EXIT_FAILURE;
+   }
+   t = now();
+   if (hshsnapsave(h, file, symhash, symflat)) {
+      perror(file);
+      return EXIT_FAILURE;
+   }
+   tsave = now() - t;
+   t = now();
+   if (!(snap = hshsnapopen(file, symhash, imagecmp))) {
+      perror(file);
+      return EXIT_FAILURE;
+   }
+   topen = now() - t;
+
+   bad = 0;
+   t = now();
+   for (found = i = 0; i < count; i++)
+      if (hshfind(h, &syms[i])) found++;
+   tfind[0] = now() - t;
+   t = now();
+   for (i = count; i < 2 * count; i++)
+      if (hshfind(h, &syms[i])) found++;
+   tfind[1] = now() - t;
+   if (found != count) bad = 1;
+   t = now();
+   for (found = i = 0; i < count; i++)
+      if ((im = hshsnapfind(snap, &syms[i]))
+          && (im->value == syms[i].value)) found++;
+   tsnap[2] = now() - t;
+   if (found != count) bad = 1;
+   t = now();
+   for (found = i = 0; i < count; i++)
+      if ((im = hshsnapfind(snap, &syms[i]))
+          && (im->value == syms[i].value)) found++;
+   tsnap[0] = now() - t;
+   t = now();
+   for (i = count; i < 2 * count; i++)
+      if (hshsnapfind(snap, &syms[i])) found++;
+   tsnap[1] = now() - t;
+   if (found != count) bad = 1;
+   total = 0;
+   hshsnapwalk(snap, imagecount, &total);
+   for (i = 0; i < count; i++) total -= syms[i].value;
+   if (total || (hshsnapstatus(snap).hentries != count)) bad = 1;
+   s = hshfind(h, &syms[0]);
+   if (!s || strcmp(s->name, syms[0].name)) bad = 1;
+
+   /* saving one symbol over the file leaves the mapped one whole */
+   h1 = hshinit(symhash, symrehash, symcmp, symdupe, symundupe, 0);
+   if (!h1 || !hshinsert(h1, &syms[0])
+       || hshsnapsave(h1, file, symhash, symflat)) bad = 1;
+   else {
+      total = 0;
+      hshsnapwalk(snap, imagecount, &total);
+      for (i = 0; i < count; i++) total -= syms[i].value;
+      if (total) bad = 1;
+   }
+   hshkill(h1);
+   hshsnapclose(snap);
+
+   /* the last slot pointing past the images */
+   if (!(fp = fopen(file, "r+b")) || fseek(fp, -16L, SEEK_END)) bad = 1;
+   else {
+      for (i = 0; i < 16; i++) putc(0xff, fp);
+      if (fclose(fp)) bad = 1;
+      else if (!(snap = hshsnapopen(file, symhash, imagecmp))) bad = 1;
+      else {
+         if ((-1 != hshsnapwalk(snap, imagecount, &total))
+             || (hshINTERR != hshsnapstatus(snap).herror)) bad = 1;
+         hshsnapclose(snap);
+      }
+   }
+
+   printf("%lu symbols\n", count);
+   printf("%-24s%10.3f s\n", "build by hshinsert", tbuild);
+   printf("%-24s%10.3f s\n", "hshsnapsave", tsave);
+   printf("%-24s%10.6f s\n", "hshsnapopen", topen);
+   printf("%-24s%10s%10s\n", "ns per search", "present", "absent");
+   printf("%-24s%10.1f%10.1f\n", "hshfind",
+          1e9 * tfind[0] / count, 1e9 * tfind[1] / count);
+   printf("%-24s%10.1f\n", "hshsnapfind, first",
+          1e9 * tsnap[2] / count);
+   printf("%-24s%10.1f%10.1f\n", "hshsnapfind",
+          1e9 * tsnap[0] / count, 1e9 * tsnap[1] / count);
+   printf("%s\n", bad ? "WRONG" : "Snapshot agrees with the table");
+
+   hshkill(h);
+   remove(file);
+   free(syms);
+   free(names);
+   return bad ? EXIT_FAILURE : 0;
+} /* main */
@@ -0,0 +1,336 @@
+/* Timing test for hashlib.hpp, the C++ template front end.
+
+   Usage: tpltest [count]
+
+   Runs the same work through a hashlib table, with its hash,
+   rehash, cmp, dupe and undupe functions called by pointer, and
+   through a hashlib::HashTable, where they are inlined and the
+   entries are stored in the slots.  For tables of count / 1000
+   up to count entries, default 1000000, it inserts them, finds
+   them all, finds as many absent keys, and deletes them, once
+   with integer keys and once with strings.  Both sides use the
+   same hash functions, so the difference is in the calls and
+   the storage.  Times vary by machine.
+
+   Needs C++11.  Link with hashlib.o.
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+#include "hashlib.h"
+#include "hashlib.hpp"
+
+/* 1------------------1 */
+
+/* The integer hash of hashtest test 5 */
+static unsigned long mix(unsigned long work)
+{
+   work += ~(work << 15);
+   work ^= ~(work << 22);
+   work += ~(work << 4);
+   work ^= ~(work << 9);
+   work += ~(work << 10);
+   work ^= ~(work << 2);
+   work += ~(work << 7);
+   work ^= ~(work << 12);
+   return work;
+} /* mix */
+
+/* ============= The C hashlib side ============= */
+
+/* An integer key and its count */
+typedef struct citem {
+   unsigned long value, count;
+} citem;
+
+extern "C" {
+
+static unsigned long chash(void *item)
+{
+   return mix(((citem *)item)->value);
+} /* chash */
+
+static unsigned long crehash(void *item)
+{
+   return ((citem *)item)->value >> 3;
+} /* crehash */
+
+static int ccmp(void *litem, void *ritem)
+{
+   unsigned long l = ((citem *)litem)->value,
+                 r = ((citem *)ritem)->value;
+
+   return (l > r) - (l < r);
+} /* ccmp */
+
+static void *cdupe(void *item)
+{
+   citem *c;
+
+   if ((c = (citem *)malloc(sizeof *c))) *c = *(citem *)item;
+   return c;
+} /* cdupe */
+
+static void cundupe(void *item)
+{
+   free(item);
+} /* cundupe */
+
+/* A string key and its count.  A stored copy keeps the */
+/* text of its key just after the struct.               */
+typedef struct sitem {
+   unsigned long count;
+   size_t        len;
+   const char   *key;
+} sitem;
+
+static unsigned long shash(void *item)
+{
+   return hshmemhash(((sitem *)item)->key, ((sitem *)item)->len);
+} /* shash */
+
+static unsigned long srehash(void *item)
+{
+   return hshmemrehash(((sitem *)item)->key, ((sitem *)item)->len);
+} /* srehash */
+
+static int scmp(void *litem, void *ritem)
+{
+   sitem *l = (sitem *)litem, *r = (sitem *)ritem;
+
+   if (l->len != r->len) return (l->len > r->len) ? 1 : -1;
+   return memcmp(l->key, r->key, l->len);
+} /* scmp */
+
+static void *sdupe(void *item)
+{
+   sitem *s, *from = (sitem *)item;
+
+   if ((s = (sitem *)malloc(sizeof *s + from->len + 1))) {
+      s->count = from->count;
+      s->len = from->len;
+      s->key = (const char *)memcpy(s + 1, from->key, from->len + 1);
+   }
+   return s;
+} /* sdupe */
+
+static void sundupe(void *item)
+{
+   free(item);
+} /* sundupe */
+
+} /* extern "C" */
+
+/* ============= The template side ============= */
+
+struct IntHash {
+   std::size_t operator()(unsigned long v) const { return mix(v); }
+};
+
+struct StrHash {
+   std::size_t operator()(const std::string &s) const
+   {
+      return hshmemhash(s.data(), s.size());
+   }
+};
+
+/* 1------------------1 */
+
+static double since(clock_t t, unsigned long n)
+{
+   return 1e9 * (clock() - t) / CLOCKS_PER_SEC / n;
+} /* since */
+
+/* 1------------------1 */
+
+/* Show the four times of one side, and whether it went right */
+static void show(const char *name, const double *ns, bool ok)
+{
+   int i;
+
+   printf("%-9s", name);
+   for (i = 0; i < 4; i++) printf("%10.1f", ns[i]);
+   printf("%s\n", ok ? "" : "  WRONG");
+} /* show */
+
+/* 1------------------1 */
+
+/* Integer keys, keys[0..n-1] present, keys[n..2n-1] absent */
+static void intrun(const std::vector<unsigned long> &keys,
+                   unsigned long n)
+{
+   hshtbl        *h;
+   citem          c, *found;
+   unsigned long  i, hits;
+   double         cns[4], tns[4];
+   clock_t        t;
+   bool           ok;
+   void          *gone;
+
+   h = hshinit(chash, crehash, ccmp, cdupe, cundupe, 0);
+   c.count = 1;
+   t = clock();
+   for (i = 0; i < n; i++) {
+      c.value = keys[i];
+      hshinsert(h, &c);
+   }
+   cns[0] = since(t, n);
+   t = clock();
+   for (hits = i = 0; i < n; i++) {
+      c.value = keys[i];
+      if ((found = (citem *)hshfind(h, &c))) hits += found->count;
+   }
+   cns[1] = since(t, n);
+   t = clock();
+   for (i = n; i < 2 * n; i++) {
+      c.value = keys[i];
+      if (hshfind(h, &c)) hits++;
+   }
+   cns[2] = since(t, n);
+   t = clock();
+   for (i = 0; i < n; i++) {
+      c.value = keys[i];
+      if ((gone = hshdelete(h, &c))) cundupe(gone);
+   }
+   cns[3] = since(t, n);
+   ok = (hits == n) && (hshstatus(h).hentries == hshstatus(h).hdeleted);
+   hshkill(h);
+   show("hashlib", cns, ok);
+
+   {
+      hashlib::HashTable<unsigned long, unsigned long, IntHash> tbl;
+      unsigned long *v;
+
+      t = clock();
+      for (i = 0; i < n; i++) tbl.insert(keys[i], 1UL);
+      tns[0] = since(t, n);
+      t = clock();
+      for (hits = i = 0; i < n; i++)
+         if ((v = tbl.find(keys[i]))) hits += *v;
+      tns[1] = since(t, n);
+      t = clock();
+      for (i = n; i < 2 * n; i++)
+         if (tbl.find(keys[i])) hits++;
+      tns[2] = since(t, n);
+      t = clock();
+      for (i = 0; i < n; i++) tbl.erase(keys[i]);
+      tns[3] = since(t, n);
+      show("template", tns, (hits == n) && !tbl.size());
+   }
+   printf("%-9s", "speedup");
+   for (i = 0; i < 4; i++) printf("%10.2f", cns[i] / tns[i]);
+   printf("\n");
+} /* intrun */
+
+/* 1------------------1 */
+
+/* String keys, names[0..n-1] present, names[n..2n-1] absent */
+static void strrun(const std::vector<std::string> &names,
+                   unsigned long n)
+{
+   hshtbl        *h;
+   sitem          s, *found;
+   unsigned long  i, hits;
+   double         cns[4], tns[4];
+   clock_t        t;
+   bool           ok;
+   void          *gone;
+
+   h = hshinit(shash, srehash, scmp, sdupe, sundupe, 0);
+   s.count = 1;
+   t = clock();
+   for (i = 0; i < n; i++) {
+      s.key = names[i].c_str();
+      s.len = names[i].size();
+      hshinsert(h, &s);
+   }
+   cns[0] = since(t, n);
+   t = clock();
+   for (hits = i = 0; i < n; i++) {
+      s.key = names[i].c_str();
+      s.len = names[i].size();
+      if ((found = (sitem *)hshfind(h, &s))) hits += found->count;
+   }
+   cns[1] = since(t, n);
+   t = clock();
+   for (i = n; i < 2 * n; i++) {
+      s.key = names[i].c_str();
+      s.len = names[i].size();
+      if (hshfind(h, &s)) hits++;
+   }
+   cns[2] = since(t, n);
+   t = clock();
+   for (i = 0; i < n; i++) {
+      s.key = names[i].c_str();
+      s.len = names[i].size();
+      if ((gone = hshdelete(h, &s))) sundupe(gone);
+   }
+   cns[3] = since(t, n);
+   ok = (hits == n) && (hshstatus(h).hentries == hshstatus(h).hdeleted);
+   hshkill(h);
+   show("hashlib", cns, ok);
+
+   {
+      hashlib::HashTable<std::string, unsigned long, StrHash> tbl;
+      unsigned long *v;
+
+      t = clock();
+      for (i = 0; i < n; i++) tbl.insert(names[i], 1UL);
+      tns[0] = since(t, n);
+      t = clock();
+      for (hits = i = 0; i < n; i++)
+         if ((v = tbl.find(names[i]))) hits += *v;
+      tns[1] = since(t, n);
+      t = clock();
+      for (i = n; i < 2 * n; i++)
+         if (tbl.find(names[i])) hits++;
+      tns[2] = since(t, n);
+      t = clock();
+      for (i = 0; i < n; i++) tbl.erase(names[i]);
+      tns[3] = since(t, n);
+      show("template", tns, (hits == n) && !tbl.size());
+   }
+   printf("%-9s", "speedup");
+   for (i = 0; i < 4; i++) printf("%10.2f", cns[i] / tns[i]);
+   printf("\n");
+} /* strrun */
+
+/* 1------------------1 */
+
+int main(int argc, char **argv)
+{
+   std::vector<unsigned long> keys;
+   std::vector<std::string>   names;
+   unsigned long              count, i, v, n;
+   char                       buf[32];
+
+   count = (argc > 1) ? strtoul(argv[1], NULL, 0) : 1000000;
+   if (!count) {
+      printf("Usage: %s [count]\n", argv[0]);
+      return EXIT_FAILURE;
+   }
+   for (i = 0; i < 2 * count; i++) {  /* scrambled, all different */
+      v = (i * 2654435761UL) & 0xffffffffUL;
+      v = ((v ^ (v >> 16)) * 0x45d9f3bUL) & 0xffffffffUL;
+      keys.push_back(v ^ (v >> 16));
+      sprintf(buf, "name%08lx", keys.back());
+      names.push_back(buf);
+   }
+
+   for (n = count / 1000 ? count / 1000 : count; ; n *= 10) {
+      if (n > count) n = count;
+      printf("\n%lu values\n", n);
+      printf("%-9s%10s%10s%10s%10s\n", "int keys", "insert",
+             "find", "absent", "delete");
+      intrun(keys, n);
+      printf("%-9s%10s%10s%10s%10s\n", "strings", "insert",
+             "find", "absent", "delete");
+      strrun(names, n);
+      if (n == count) break;
+   }
+   return 0;
+} /* main */
@@ -7,21 +7,58 @@
    of number of occurances.
 
    The database is implemented through use of the hashlib
-   package.  When loaded, a singly linked list is formed from
-   the content by the hashwalk feature, and sorted with a
-   mergesort.
+   package.  When loaded, an array of the content is formed by
+   the hashwalk feature, and sorted.
 
    by C.B. Falconer, 2002-03-12
    Put in public domain.  Attribution appreciated.
+
+   2026-10-18  Given a file name, the file is mapped into memory
+   with mmap and cut at word boundaries into as many parts as
+   there are threads, each counted into a table of its own by
+   a thread of its own, and the tables are then merged into
+   one.  The words are found and downshifted 16 bytes at a time
+   with SSE2 where available.  The output is the same as when
+   the file is read from stdin, but for the probe statistics.
+   This needs POSIX threads and mmap.
+
+   2026-10-18  The linked list and its two mergesorts are gone.
+   The items are put in an array, ordered by a radix sort on
+   their counts, and alphabetically only within runs of equal
+   counts.  With -k N just the first N are kept, in a heap,
+   while walking the table, and nothing else is sorted.
+
+   2026-10-18  With -s M only M words are counted at any time,
+   by the Space-Saving algorithm, so that a stream of any
+   length is counted in fixed memory, about 150 bytes a word.
+   A word not counted takes the place of the one with the
+   least count, and starts from that count plus one.  After N
+   words every count is high by at most N / M, and at most by
+   the least count, which is shown.  Any word occurring more
+   than N / M times is sure to be counted.  With -p P the top
+   words, k of them or else 10, are shown every P words.
 */
 
+#define _POSIX_C_SOURCE 200112L
+
 #include <stdio.h>
 #include <ctype.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
 #include "hashlib.h"
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
 
 #define MAXWD 72
+#define MAXTHREADS 64
 
 /* ================================== */
 /* Routines for text input and output */
@@ -47,7 +84,8 @@ static int akeyboard(FILE *fp)
 /* 1------------------1 */
 
 /* Get the next word consisting of alpha chars */
-/* Return the terminating character (or EOF)   */
+/* Return the terminating character, '\n' for  */
+/* a word ended by EOF, or EOF for no word     */
 /* Downshift the acquired word                 */
 static int nextword(FILE *f, char *buffer, int max)
 {
@@ -61,10 +99,104 @@ static int nextword(FILE *f, char *buffer, int max)
          if (i < max) buffer[i++] = tolower(ch);
       } while (isalpha(ch = getc(f)));
       buffer[i] = '\0';    /* terminate string */
+      if (EOF == ch) ch = '\n';   /* the last word counts */
    }
    return ch;
 } /* nextword */
 
+/* ================================== */
+/* Routines for a file mapped in      */
+/* ================================== */
+
+/* lower[c] is c downshifted if isalpha(c), else 0.  As the */
+/* program never calls setlocale, isalpha is true for just  */
+/* the ASCII letters, which the SSE2 code relies on.        */
+static unsigned char lower[UCHAR_MAX + 1];
+
+static void initlower(void)
+{
+   int c;
+
+   for (c = 0; c <= UCHAR_MAX; c++)
+      lower[c] = isalpha(c) ? tolower(c) : 0;
+} /* initlower */
+
+/* 1------------------1 */
+
+#ifdef __SSE2__
+/* The bit mask of the letters among the 16 bytes at p.  With */
+/* 0x20 or'ed in, a letter is one of 'a' to 'z', and adding   */
+/* 0x80 - 'a' puts those just at the bottom of signed bytes.  */
+static unsigned int letters16(const unsigned char *p)
+{
+   __m128i v;
+
+   v = _mm_or_si128(_mm_loadu_si128((const __m128i *)p),
+                    _mm_set1_epi8(0x20));
+   v = _mm_add_epi8(v, _mm_set1_epi8(0x80 - 'a'));
+   return _mm_movemask_epi8(_mm_cmplt_epi8(v,
+                                           _mm_set1_epi8(-128 + 26)));
+} /* letters16 */
+
+/* 1------------------1 */
+
+/* index of the lowest set bit of m, which is not 0 */
+static unsigned int lowbit(unsigned int m)
+{
+# ifdef __GNUC__
+   return __builtin_ctz(m);
+# else
+   unsigned int i;
+
+   for (i = 0; !(m & 1); m >>= 1) i++;
+   return i;
+# endif
+} /* lowbit */
+#endif
+
+/* 1------------------1 */
+
+/* The first of p up to end that is a letter, or that is not */
+/* a letter, as letter says.  end if there is none.          */
+static const unsigned char *scanto(const unsigned char *p,
+                                   const unsigned char *end,
+                                   int letter)
+{
+#ifdef __SSE2__
+   unsigned int m;
+
+   for (; end - p >= 16; p += 16) {
+      m = letters16(p);
+      if (!letter) m = ~m & 0xffff;
+      if (m) return p + lowbit(m);
+   }
+#endif
+   while ((p < end) && ((0 != lower[*p]) != letter)) p++;
+   return p;
+} /* scanto */
+
+/* 1------------------1 */
+
+/* Copy the first max - 1 or fewer letters at p, up to end,  */
+/* downshifted, into buffer as a string, as nextword would.  */
+static void copyword(const unsigned char *p, const unsigned char *end,
+                     char *buffer, int max)
+{
+   size_t i, n;
+
+   n = end - p;
+   if (n > (size_t)max - 1) n = max - 1;
+   i = 0;
+#ifdef __SSE2__
+   for (; n - i >= 16; i += 16)   /* all letters, or 0x20 */
+      _mm_storeu_si128((__m128i *)(buffer + i),
+         _mm_or_si128(_mm_loadu_si128((const __m128i *)(p + i)),
+                      _mm_set1_epi8(0x20)));
+#endif
+   for (; i < n; i++) buffer[i] = lower[p[i]];
+   buffer[n] = '\0';
+} /* copyword */
+
 /* ==================================== */
 /* Routines to interface the hash table */
 /* ==================================== */
@@ -73,7 +205,6 @@ static int nextword(FILE *f, char *buffer, int max)
 typedef struct wordlink {
    char            *word;   /* Points to the word itself */
    unsigned long    count;  /* of occurances */
-   struct wordlink *next;   /* Used to create a list */
 } wordlink, *wordlinkp;
 
 /* ==================================================== */
@@ -96,7 +227,6 @@ static void * hwdupe(void * hwdin)
       if ((item->word = malloc(lgh))) {
          strcpy(item->word, hwd->word);
          item->count = 0;
-         item->next = NULL; /* on principle */
       }
       else {
          free(item);
@@ -171,9 +301,124 @@ static void * store(char *wd, hshtbl *h)
 
 /* 1------------------1 */
 
+/* One part of a mapped file, and the thread counting it */
+typedef struct counter {
+   const unsigned char *first, *last;  /* text first..last-1 */
+   hshtbl              *h;              /* its words */
+   unsigned long        wdcount;
+   int                  full;           /* store failed */
+} counter;
+
+/* Count the words of one part into a table of its own */
+static void *countpart(void *arg)
+{
+   counter             *c = arg;
+   const unsigned char *p, *q;
+   char                 wdbuffer[MAXWD];
+
+   c->wdcount = 0;
+   c->full = 0;
+   if (!(c->h = hshinit(hwdhash, hwdrehash, hwdcmp,
+                        hwdupe, hwdundupe, 0))) {
+      c->full = 1;
+      return NULL;
+   }
+   for (p = c->first; (p = scanto(p, c->last, 1)) < c->last; p = q) {
+      q = scanto(p, c->last, 0);
+      copyword(p, q, wdbuffer, MAXWD);
+      if (!store(wdbuffer, c->h)) {
+         c->full = 1;
+         break;
+      }
+      c->wdcount++;
+   }
+   return NULL;
+} /* countpart */
+
+/* 1------------------1 */
+
+/* hshwalk function adding an item of one table, with its */
+/* count, to the table datum                              */
+static int mergeone(void *item, void *datum, void *xtra)
+{
+   wordlinkp wd = item, into;
+
+   (void) xtra;
+   if (!(into = hshinsert(datum, wd))) return 1;
+   into->count += wd->count;
+   return 0;
+} /* mergeone */
+
+/* 1------------------1 */
+
+/* Count the words of the file named, with nthreads threads, */
+/* returning their table, with their number in *wdcount.     */
+/* NULL if the file can not be read.                         */
+static hshtbl *countfile(const char *name, int nthreads,
+                         unsigned long *wdcount)
+{
+   counter              c[MAXTHREADS];
+   pthread_t            tid[MAXTHREADS];
+   int                  started[MAXTHREADS];
+   const unsigned char *base, *b;
+   struct stat          sb;
+   size_t               size;
+   int                  fd, i, full;
+   hshtbl              *h;
+
+   if ((fd = open(name, O_RDONLY)) < 0) return NULL;
+   if (fstat(fd, &sb)) {
+      close(fd);
+      return NULL;
+   }
+   size = sb.st_size;
+   base = NULL;
+   if (size && (MAP_FAILED == (base = mmap(NULL, size, PROT_READ,
+                                           MAP_PRIVATE, fd, 0)))) {
+      close(fd);
+      return NULL;
+   }
+   close(fd);
+   if (size) posix_madvise((void *)base, size, POSIX_MADV_SEQUENTIAL);
+   initlower();
+
+   /* cut after whole words, so no word is split */
+   for (b = base, i = 0; i < nthreads; i++) {
+      c[i].first = b;
+      if (i == nthreads - 1) b = base + size;
+      else if (b < base + size / nthreads * (i + 1))
+         b = scanto(base + size / nthreads * (i + 1), base + size, 0);
+      c[i].last = b;
+   }
+   for (i = 1; i < nthreads; i++)
+      started[i] = !pthread_create(&tid[i], NULL, countpart, &c[i]);
+   countpart(&c[0]);
+   for (i = 1; i < nthreads; i++) {
+      if (started[i]) pthread_join(tid[i], NULL);
+      else countpart(&c[i]);
+   }
+
+   /* merge all into the first table */
+   h = c[0].h;
+   full = c[0].full;
+   *wdcount = c[0].wdcount;
+   for (i = 1; i < nthreads; i++) {
+      if (h && c[i].h && hshwalk(c[i].h, mergeone, h)) full = 1;
+      full |= c[i].full;
+      *wdcount += c[i].wdcount;
+      hshkill(c[i].h);
+   }
+   if (size) munmap((void *)base, size);
+   if (full) puts("No more room in table or memory exhausted");
+   return h;
+} /* countfile */
+
+/* 1------------------1 */
+
 /* define a data type for the datum item in tablewalkfn */
 typedef struct walkglobals {
-   void *previtem;
+   wordlinkp     *words;   /* the array being filled */
+   unsigned long  n;       /* entries used so far    */
 } walkglobals;
 
 /* This function is called for each item in the database
@@ -188,136 +433,401 @@ typedef struct walkglobals {
 static int tablewalkfn(void *item, void *datum, void *xtra)
 {
    walkglobals *global = datum;
-   wordlinkp    wdlink = item;
 
-   wdlink->next     = global->previtem;
-   global->previtem = wdlink;
+   (void) xtra;
+   global->words[global->n++] = item;
    return 0;  /* i.e. no error occured */
 } /* tablewalkfn */
 
 /* 1------------------1 */
 
-/* together with tablewalkfn, this uses the 'next' fields
-   of the stored items to form a singly linked list */
-static wordlinkp formlist(hshtbl *h)
+/* together with tablewalkfn, this puts pointers to all the
+   stored items in an array of n, in no particular order.
+   NULL if out of memory */
+static wordlinkp *formarray(hshtbl *h, unsigned long n)
 {
    walkglobals globs;
-   int         err;
 
-   globs.previtem = NULL;  /* start with end of list */
+   if (!(globs.words = malloc((n ? n : 1) * sizeof *globs.words)))
+      return NULL;
+   globs.n = 0;
+   (void) hshwalk(h, tablewalkfn, &globs);
+   return globs.words;
+} /* formarray */
 
-   /* Now we can scan all active items in the table */
-   /* We are saving the err return for completeness */
-   /* only.  tablewalkfn() never returns an error   */
-   err = hshwalk(h, tablewalkfn, &globs);
+/* 1------------------1 */
 
-   return globs.previtem;  /* now this is head of list */
-} /* formlist */
+/* Does l come out before r, having more occurances, or as  */
+/* many and being first alphabetically                      */
+static int before(wordlinkp l, wordlinkp r)
+{
+   if (l->count != r->count) return l->count > r->count;
+   return strcmp(l->word, r->word) < 0;
+} /* before */
 
 /* 1------------------1 */
 
-/* split list p into 2 nearly equal lists, return 2nd part */
-static wordlinkp splitlist(wordlinkp p)
+/* qsort comparison of two pointers to words, alphabetically */
+static int alphacmp(const void *l, const void *r)
 {
-   wordlinkp p1, p2, p3;
+   return strcmp((*(const wordlinkp *)l)->word,
+                 (*(const wordlinkp *)r)->word);
+} /* alphacmp */
 
-   p1 = p2 = p3 = p;
-   if (!p) return NULL;
-   do {
-      p3 = p2;
-      p2 = p2->next;           /* advance 1 */
-      p1 = p1->next;
-      if (p1) p1 = p1->next;   /* advance 2 */
-   } while (p1);
+/* 1------------------1 */
 
-   /* now form new list after p2 */
-   p3->next = NULL; /* terminate 1st half */
-   return p2;
-} /* splitlist */
+/* Put the n words in order of output: by decreasing count,
+   with an LSD radix sort of the counts a byte at a time,
+   which is stable and linear, and then each run of equal
+   counts alphabetically.  Only as many bytes are sorted on
+   as the biggest count has, usually two or three.  spare
+   has room for n more.  Returns words or spare, whichever
+   ends up holding the result. */
+static wordlinkp *radixorder(wordlinkp *words, wordlinkp *spare,
+                             unsigned long n)
+{
+   unsigned long  bucket[UCHAR_MAX + 1];
+   unsigned long  i, j, max, sum, t;
+   unsigned int   shift, d;
+   wordlinkp     *tmp;
+
+   for (max = i = 0; i < n; i++)
+      if (words[i]->count > max) max = words[i]->count;
+   for (shift = 0; max; shift += CHAR_BIT, max >>= CHAR_BIT) {
+      for (d = 0; d <= UCHAR_MAX; d++) bucket[d] = 0;
+      for (i = 0; i < n; i++)
+         bucket[UCHAR_MAX - ((words[i]->count >> shift) & UCHAR_MAX)]++;
+      for (sum = 0, d = 0; d <= UCHAR_MAX; d++) {
+         t = bucket[d]; bucket[d] = sum; sum += t;
+      }
+      for (i = 0; i < n; i++)
+         spare[bucket[UCHAR_MAX
+                      - ((words[i]->count >> shift) & UCHAR_MAX)]++]
+            = words[i];
+      tmp = words; words = spare; spare = tmp;
+   }
+   for (i = 0; i < n; i = j) {
+      for (j = i + 1; (j < n) && (words[j]->count == words[i]->count); j++)
+         continue;
+      if (j - i > 1) qsort(words + i, j - i, sizeof *words, alphacmp);
+   }
+   return words;
+} /* radixorder */
 
 /* 1------------------1 */
 
-/* Merge two ordered lists into one */
-static wordlinkp mergelists(wordlinkp p1, wordlinkp p2,
-                            hshcmpfn cmp) /* compare */
+/* The k words that come out first, in a heap with the one
+   that comes out last of them at the top */
+typedef struct topk {
+   wordlinkp     *heap;
+   unsigned long  k, n;      /* room for k, n used */
+   unsigned long  sigma;     /* of all counts seen */
+} topk;
+
+/* Move heap[i] down to its place, below both children */
+static void siftdown(wordlinkp *heap, unsigned long n, unsigned long i)
 {
-   wordlink  n;
-   wordlinkp p;
+   unsigned long c;
+   wordlinkp     t;
+
+   while ((c = 2 * i + 1) < n) {
+      if ((c + 1 < n) && before(heap[c], heap[c + 1])) c++;
+      if (!before(heap[i], heap[c])) break;
+      t = heap[i]; heap[i] = heap[c]; heap[c] = t;
+      i = c;
+   }
+} /* siftdown */
 
-   p = &n;
-   n.next = p;
+/* 1------------------1 */
 
-   while (p1 && p2) {
-      if (cmp(p1, p2) <= 0) {
-         p->next = p1; p = p1; p1 = p1->next;
-      }
-      else {
-         p->next = p2; p = p2; p2 = p2->next;
+/* hshwalk function keeping the k first words in a topk */
+static int topkwalkfn(void *item, void *datum, void *xtra)
+{
+   topk          *top = datum;
+   wordlinkp      wd = item, t;
+   unsigned long  i;
+
+   (void) xtra;
+   top->sigma += wd->count;
+   if (top->n < top->k) {        /* still filling, sift up */
+      i = top->n++;
+      top->heap[i] = wd;
+      while (i && before(top->heap[(i - 1) / 2], top->heap[i])) {
+         t = top->heap[i];
+         top->heap[i] = top->heap[(i - 1) / 2];
+         top->heap[(i - 1) / 2] = t;
+         i = (i - 1) / 2;
       }
    }
-   /* at least one list now empty, copy other */
-   /* one or both of these operations is null */
-   if (p1) p->next = p1;
-   if (p2) p->next = p2;
+   else if (before(wd, top->heap[0])) {
+      top->heap[0] = wd;
+      siftdown(top->heap, top->n, 0);
+   }
+   return 0;
+} /* topkwalkfn */
 
-   /* check for empty lists */
-   if (n.next == &n) return NULL;
-   return n.next;
-} /* mergelists */
+/* 1------------------1 */
+
+/* Show the first k words of table h, in order, in time    */
+/* proportional to entries * log k.  Returns the sum of the */
+/* counts of all the words, 0 if out of memory.            */
+static unsigned long showtopk(hshtbl *h, unsigned long k)
+{
+   topk          top;
+   unsigned long  i;
+   wordlinkp      t;
+
+   if (!(top.heap = malloc(k * sizeof *top.heap))) return 0;
+   top.k = k;
+   top.n = top.sigma = 0;
+   (void) hshwalk(h, topkwalkfn, &top);
+   for (i = top.n; i-- > 1; ) {     /* heapsort, last out first */
+      t = top.heap[0]; top.heap[0] = top.heap[i]; top.heap[i] = t;
+      siftdown(top.heap, i, 0);
+   }
+   for (i = 0; i < top.n; i++)
+      printf("%6lu %s\n", top.heap[i]->count, top.heap[i]->word);
+   free(top.heap);
+   return top.sigma;
+} /* showtopk */
+
+/* ================================== */
+/* Heavy hitters in bounded memory    */
+/* ================================== */
+
+/* One of the M counters of the Space-Saving algorithm.  The */
+/* table holds the wl fields, so that all the code for whole */
+/* tables serves as well, and wl is first so that a pointer  */
+/* to it is one to the counter.                              */
+typedef struct sscounter {
+   wordlink       wl;            /* wl.word is text */
+   unsigned long  err;           /* wl.count may be this high */
+   unsigned long  at;            /* index in the heap */
+   char           text[MAXWD];
+} sscounter;
+
+/* All the counters, with the least count on top of the heap */
+typedef struct spacesaving {
+   hshtbl        *h;
+   sscounter     *pool;          /* m of them */
+   sscounter    **heap;          /* used of them */
+   unsigned long  m, used;
+} spacesaving;
 
 /* 1------------------1 */
 
-/* Recursively sort a linked list. The sort is stable */
-/* This is an O(NlogN) process for all lists.         */
-static wordlinkp mergesort(wordlinkp root, hshcmpfn cmp)
+/* The table holds the counters themselves, never copies */
+static void * ssdupe(void *item)
 {
-   wordlinkp p;
+   return item;
+} /* ssdupe */
 
-   if (root && root->next) {  /* 2 up items in list */
-      p = splitlist(root);    /* alters list root */
-      root = mergelists(mergesort(root, cmp),
-                        mergesort(   p, cmp),
-                        cmp);
+/* 1------------------1 */
+
+/* The counters are freed with the pool */
+static void ssundupe(void *item)
+{
+   (void) item;
+} /* ssundupe */
+
+/* 1------------------1 */
+
+/* Move heap[i] down to its place, after its count has grown */
+static void sssiftdown(spacesaving *ss, unsigned long i)
+{
+   unsigned long  c;
+   sscounter     *t;
+
+   while ((c = 2 * i + 1) < ss->used) {
+      if ((c + 1 < ss->used)
+          && (ss->heap[c + 1]->wl.count < ss->heap[c]->wl.count)) c++;
+      if (ss->heap[i]->wl.count <= ss->heap[c]->wl.count) break;
+      t = ss->heap[i]; ss->heap[i] = ss->heap[c]; ss->heap[c] = t;
+      ss->heap[i]->at = i;
+      ss->heap[c]->at = c;
+      i = c;
    }
-/* else the unit or empty list is already sorted */
+} /* sssiftdown */
+
+/* 1------------------1 */
 
-   return root;
-} /* mergesort */
+/* Set up for m counters, all unused.  0 if out of memory */
+static int ssinit(spacesaving *ss, unsigned long m)
+{
+   hshopts opts;
+
+   opts.mode = hshROBIN;    /* deletes leave no DELETED slots */
+   opts.reserve = m;
+   opts.adupe = NULL;
+   ss->m = m;
+   ss->used = 0;
+   ss->pool = malloc(m * sizeof *ss->pool);
+   ss->heap = malloc(m * sizeof *ss->heap);
+   ss->h = hshinitopts(hwdhash, hwdrehash, hwdcmp,
+                       ssdupe, ssundupe, 0, &opts);
+   return ss->pool && ss->heap && ss->h;
+} /* ssinit */
 
 /* 1------------------1 */
 
-/* Compare the count fields, return +1, 0, -1 */
-static int countcmp(void *litem, void *ritem)
+/* Count one more occurance of wd.  NULL on failure */
+static void * sscount(spacesaving *ss, char *wd)
 {
-   wordlinkp li = litem,
-             ri = ritem;
+   wordlink       key;
+   wordlinkp      wl;
+   sscounter     *c;
+   unsigned long  i;
+
+   key.word = wd;
+   if ((wl = hshfind(ss->h, &key))) {
+      wl->count++;
+      sssiftdown(ss, ((sscounter *)wl)->at);
+      return wl;
+   }
+   if (ss->used < ss->m) {       /* a fresh counter, at the top */
+      c = &ss->pool[ss->used];
+      c->err = 0;
+      for (i = ss->used++; i; i = (i - 1) / 2) {  /* all >= 1 */
+         ss->heap[i] = ss->heap[(i - 1) / 2];
+         ss->heap[i]->at = i;
+      }
+      ss->heap[0] = c;
+      c->at = 0;
+   }
+   else {                        /* replace the least */
+      c = ss->heap[0];
+      (void) hshdelete(ss->h, &c->wl);
+      c->err = c->wl.count;
+   }
+   strcpy(c->text, wd);
+   c->wl.word = c->text;
+   c->wl.count = c->err + 1;
+   sssiftdown(ss, 0);
+   return hshinsert(ss->h, &c->wl);
+} /* sscount */
 
-   return (li->count < ri->count) - (li->count > ri->count);
-} /* hwdcmp */
+/* 1------------------1 */
+
+/* The most any count is too high, the least count once all */
+/* the counters are in use.                                 */
+static unsigned long sserror(spacesaving *ss)
+{
+   return (ss->used < ss->m) ? 0 : ss->heap[0]->wl.count;
+} /* sserror */
+
+/* 1------------------1 */
+
+/* Count the words of f into ss, showing the top k every   */
+/* words, unless every is 0.  Returns the table of counts, */
+/* with the number of words in *wdcount.                   */
+static hshtbl *countstream(FILE *f, spacesaving *ss,
+                           unsigned long every, unsigned long k,
+                           unsigned long *wdcount)
+{
+   char wdbuffer[MAXWD];
+
+   *wdcount = 0;
+   while (EOF != nextword(f, wdbuffer, MAXWD)) {
+      if (!sscount(ss, wdbuffer)) {
+         puts("No more room in table or memory exhausted");
+         break;
+      }
+      ++*wdcount;
+      if (every && !(*wdcount % every)) {
+         printf("--- %lu words, counts at most %lu high\n",
+                *wdcount, sserror(ss));
+         (void) showtopk(ss->h, k);
+         fflush(stdout);
+      }
+   }
+   return ss->h;
+} /* countstream */
 
 /* 1------------------1 */
 
-int main(void)
+int main(int argc, char **argv)
 {
    char     wdbuffer[MAXWD];
    hshtbl  *h = NULL; /* Stores only one copy of each word */
    hshstats hs;
-   unsigned long wdcount, sigma;
-   wordlinkp wds;     /* head of singly linked list */
+   unsigned long wdcount, sigma, n, i, k;
+   wordlinkp *wds, *spare, *sorted;
+   const char *file;  /* mapped instead of stdin */
+   int      nthreads, a;
+   unsigned long ssm, every;   /* -s and -p */
+   spacesaving ss;
+   FILE    *f;
+
+   file = NULL;
+   k = 0;             /* show all */
+   ssm = every = 0;   /* count all words exactly */
+#ifdef _SC_NPROCESSORS_ONLN
+   nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+#else
+   nthreads = 1;
+#endif
+   if (nthreads < 1) nthreads = 1;
+   if (nthreads > MAXTHREADS) nthreads = MAXTHREADS;
+   for (a = 1; a < argc; a++) {
+      if (!strcmp(argv[a], "-t") && (a + 1 < argc))
+         nthreads = atoi(argv[++a]);
+      else if (!strcmp(argv[a], "-k") && (a + 1 < argc)) {
+         if (!(k = strtoul(argv[++a], NULL, 10))) break;
+      }
+      else if (!strcmp(argv[a], "-s") && (a + 1 < argc)) {
+         if (!(ssm = strtoul(argv[++a], NULL, 10))) break;
+      }
+      else if (!strcmp(argv[a], "-p") && (a + 1 < argc)) {
+         if (!(every = strtoul(argv[++a], NULL, 10))) break;
+      }
+      else if (!file && ('-' != argv[a][0])) file = argv[a];
+      else break;
+   }
+   if ((a < argc) || (nthreads < 1) || (nthreads > MAXTHREADS)
+       || (every && !ssm)) {
+      puts("Usage: wdfreq [-k N] [-t threads] [inputfile] > outputfile");
+      puts("   or: wdfreq -s M [-p P] [-k N] [inputfile] > outputfile");
+      return EXIT_FAILURE;
+   }
 
-   if (akeyboard(stdin)) {
+   if (!file && akeyboard(stdin)) {
       puts("Usage: wdfreq < inputfile > outputfile");
+      puts("   or: wdfreq [-k N] [-t threads] inputfile > outputfile");
       puts(" collects all words in inputfile and outputs a");
       puts(" sorted (by frequency) list of words and the");
-      puts(" frequency of their occurences, ignores case.\n");
+      puts(" frequency of their occurences, ignores case.");
+      puts(" A named inputfile is mapped into memory, and");
+      puts(" counted by threads threads, default one per cpu.");
+      puts(" -k N lists only the N most frequent words.");
+      puts(" -s M counts at most M words at a time, in fixed");
+      puts(" memory, and -p P shows the top words every P.\n");
       puts("Signal EOF to terminate (^D or ^Z usually)");
    }
 
+   if (ssm) {
+      /* Approximate, in fixed memory, from a stream */
+      if (!(f = file ? fopen(file, "r") : stdin)) {
+         perror(file);
+         return EXIT_FAILURE;
+      }
+      if (!ssinit(&ss, ssm)) {
+         puts("No memory for the counters");
+         return EXIT_FAILURE;
+      }
+      h = countstream(f, &ss, every, k ? k : 10, &wdcount);
+      if (file) fclose(f);
+   }
+   else if (file) {
+      if (!(h = countfile(file, nthreads, &wdcount))) {
+         perror(file);
+         return EXIT_FAILURE;
+      }
+   }
    /* Create a table for storing words */
-   if ((h = hshinit(hwdhash, hwdrehash,
-                    hwdcmp,
-                    hwdupe,  hwdundupe,
-                    0))) {
+   else if ((h = hshinit(hwdhash, hwdrehash,
+                         hwdcmp,
+                         hwdupe,  hwdundupe,
+                         0))) {
       wdcount = 0;
       while (EOF != nextword(stdin, wdbuffer, MAXWD)) {
          if (!store(wdbuffer, h)) break;
@@ -325,7 +835,8 @@ int main(void)
       }
       /* Either EOF or we ran out of storage space */
       /* In either case we can collect no more data */
-
+   }
+   if (h) {
       /* collect some statistics, for curiosity */
       hs = hshstatus(h);
       if (hs.herror & (hshTBLFULL | hshNOMEM)) {
@@ -336,25 +847,30 @@ int main(void)
       }
       printf("%lu words, %lu entries, %lu probes, %lu misses\n",
               wdcount, hs.hentries, hs.probes, hs.misses);
+      if (ssm)
+         printf("counts at most %lu high\n", sserror(&ss));
 
-      /* Make a singly linked list of the words */
-      wds = formlist(h);
-
-      /* For stability demo, this first sort uses
-         the string comparison function for the hashtable */
-      wds = mergesort(wds, hwdcmp);
-
-      /* because the sort is stable, all items with
-         the same count value will be in alpha order
-         Note how the sort is controlled by cmp function */
-      wds = mergesort(wds, countcmp);
-
-      /* dump everything */
-      sigma = 0;
-      while (wds) {
-         printf("%6lu %s\n", wds->count, wds->word);
-         sigma += wds->count;
-         wds = wds->next;
+      n = hs.hentries - hs.hdeleted;
+      if (k && (k < n)) {
+         /* Only the first k, the rest are never sorted */
+         sigma = showtopk(h, k);
+      }
+      else {
+         /* An array of the words, with as much again to sort */
+         wds = formarray(h, n);
+         spare = malloc((n ? n : 1) * sizeof *spare);
+         sigma = 0;
+         if (wds && spare) {
+            sorted = radixorder(wds, spare, n);
+
+            /* dump everything */
+            for (i = 0; i < n; i++) {
+               printf("%6lu %s\n", sorted[i]->count, sorted[i]->word);
+               sigma += sorted[i]->count;
+            }
+         }
+         free(wds);
+         free(spare);
       }
 
       /* Sanity check */
@@ -368,6 +884,10 @@ int main(void)
       items in the table.  Omitting it does no harm here
       because program exit will normally release it all */
    hshkill(h);   /* free all the storage */
+   if (ssm) {
+      free(ss.pool);
+      free(ss.heap);
+   }
 
    return 0;
 } /* main */ /* wdfreq.c */
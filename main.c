@@ -27,10 +27,20 @@ int main(int argc, char** argv){
 	hshtbl* varTable;
 	firstPartials frstpartials;
 	int i;
+	int showStats = 0;
+	
+	/* --stats prints the statistics of the engine after the derivatives
+	 **/
+	if (argc > 1 && strcmp(argv[1],"--stats") == 0){
+		showStats = 1;
+		setStatsTiming(1);
+		argc--;
+		argv++;
+	}
 		
 	/*Test for number of command line arguments*/
 	if (argc < 3){
-		fprintf(stderr,"Usage: DE <TYPE-I filename> <TYPE-II filename>\n");
+		fprintf(stderr,"Usage: DE [--stats] <TYPE-I filename> <TYPE-II filename>\n");
 		return 0;		
 	}	
 	else if (argc > 2) {
@@ -61,6 +71,9 @@ int main(int argc, char** argv){
 		for(i=0; i<frstpartials.count;i++){
 			printf("1st Derivative of F wrt %s = %f\n",(frstpartials.varName[i]),*((frstpartials.partials)+i));
 		}
+		
+		if (showStats)
+			printStats(stderr);
 				
 		/* Deallocated the memory allocated for the hashmap */		
 		hshkill(varTable);
@@ -0,0 +1,236 @@
+/******************************************************************
+* Author: Mahesh Narayanamurthi
+* e- Mail : mahesh.mach@gmail.com
+* Description: Differentiation Exercise -  GSoC
+* Created with: Geany
+* Vector kernels for the transcendental functions used by the batch
+* forward and reverse replays in DE.c
+******************************************************************/
+
+#include <math.h>
+#include <float.h>
+#include <string.h>
+#include <stdint.h>
+
+#ifndef _VECMATH_H_
+	#include "vecmath.h"
+#endif
+
+/* Description: On x86-64 Linux GCC builds one copy of every kernel per
+ * listed target and binds the best one for the running CPU when the
+ * program is loaded. Elsewhere a single portable copy is built.
+ * */
+#if defined(__GNUC__) && defined(__x86_64__) && defined(__linux__)
+	#define VECMATH_CLONES __attribute__((target_clones("avx512f","avx2","default")))
+	/* The loops only vectorize at O3, and the clamps and selects only
+	 * if-convert when floating point traps need not be preserved */
+	#pragma GCC optimize ("O3", "no-trapping-math")
+#else
+	#define VECMATH_CLONES
+#endif
+
+/* Adding this to a double of magnitude below 2^51 rounds it to an integer
+ * which then sits in the low bits of the representation */
+#define SHIFT 6755399441055744.0	/* 0x1.8p52 */
+
+#define INVLN2 1.4426950408889634074
+/* ln 2 split so that k * LN2HI is exact for |k| < 2^11 */
+#define LN2HI 6.93147180369123816490e-01
+#define LN2LO 1.90821492927058770002e-10
+
+#define TWOBYPI 6.36619772367581382433e-01
+/* pi/2 split in 33 bit pieces (fdlibm), k * piece is exact for k < 2^20 */
+#define PIO2_1 1.57079632673412561417e+00
+#define PIO2_2 6.07710050650619224932e-11
+#define PIO2_3 2.02226624879595063154e-21
+
+/* Beyond this sin and cos are handed to libm */
+#define TRIG_LIMIT 1e5
+
+#define SQRT2 1.41421356237309504880
+
+static double asDouble(uint64_t bits){
+	double d;
+	memcpy(&d, &bits, sizeof d);
+	return d;
+}
+
+static uint64_t asBits(double d){
+	uint64_t bits;
+	memcpy(&bits, &d, sizeof bits);
+	return bits;
+}
+
+/* Description: 2^k for an integral double k in [-1022,1023].
+ * */
+static double twoTo(double k){
+	return asDouble((asBits(k + SHIFT) + 1023) << 52);
+}
+
+/* Description: exp of one lane. x = k ln2 + r with |r| <= ln2/2, exp(r) by
+ * its Taylor polynomial of degree 13 (truncation below 1e-17) and 2^k
+ * applied in two halves so that results down in the subnormal range and
+ * up to overflow come out right. NaN propagates, -inf gives 0 and +inf
+ * gives inf through the clamp.
+ * */
+static double expLane(double x){
+	double kd, k1, r, p;
+
+	x = (x > 710.0) ? 710.0 : x;
+	x = (x < -746.0) ? -746.0 : x;
+	kd = (x * INVLN2 + SHIFT) - SHIFT;
+	r = (x - kd * LN2HI) - kd * LN2LO;
+	p = 1.0/6227020800.0;
+	p = 1.0/479001600.0 + r * p;
+	p = 1.0/39916800.0 + r * p;
+	p = 1.0/3628800.0 + r * p;
+	p = 1.0/362880.0 + r * p;
+	p = 1.0/40320.0 + r * p;
+	p = 1.0/5040.0 + r * p;
+	p = 1.0/720.0 + r * p;
+	p = 1.0/120.0 + r * p;
+	p = 1.0/24.0 + r * p;
+	p = 1.0/6.0 + r * p;
+	p = 0.5 + r * p;
+	p = 1.0 + r * p;
+	p = 1.0 + r * p;
+	k1 = (kd * 0.5 + SHIFT) - SHIFT;
+	return p * twoTo(k1) * twoTo(kd - k1);
+}
+
+/* Description: log of one lane. x = 2^e m with sqrt(1/2) <= m < sqrt(2),
+ * log m = 2 atanh f with f = (m-1)/(m+1), |f| <= 0.172, by its series up
+ * to f^23 (truncation below 1e-18). Subnormals are scaled up first; 0,
+ * negative numbers, inf and NaN are selected at the end.
+ * */
+static double logLane(double x){
+	uint64_t bits;
+	double m, e, f, s, p, y, special;
+	int tiny = x < DBL_MIN;
+
+	bits = asBits(tiny ? x * 18014398509481984.0 : x);	/* 2^54 */
+	m = asDouble((bits & 0x000fffffffffffffULL) | 0x3ff0000000000000ULL);
+	e = asDouble(0x4330000000000000ULL | (bits >> 52)) - 4503599627370496.0 - 1023.0;
+	e = tiny ? e - 54.0 : e;
+	e = (m > SQRT2) ? e + 1.0 : e;
+	m = (m > SQRT2) ? m * 0.5 : m;
+	f = (m - 1.0) / (m + 1.0);
+	s = f * f;
+	p = 1.0/23;
+	p = 1.0/21 + s * p;
+	p = 1.0/19 + s * p;
+	p = 1.0/17 + s * p;
+	p = 1.0/15 + s * p;
+	p = 1.0/13 + s * p;
+	p = 1.0/11 + s * p;
+	p = 1.0/9 + s * p;
+	p = 1.0/7 + s * p;
+	p = 1.0/5 + s * p;
+	p = 1.0/3 + s * p;
+	y = e * LN2HI + (e * LN2LO + (2.0 * f + 2.0 * f * s * p));
+	special = (x == 0.0) ? -HUGE_VAL : ((x > 0.0) ? x : NAN);
+	return (x > 0.0 && x <= DBL_MAX) ? y : special;
+}
+
+/* Description: sin of one lane, or cos when quadrant is 1. x = k pi/2 + r
+ * with |r| <= pi/4 by Cody-Waite reduction, then the sine or cosine
+ * Taylor polynomial on r (truncation below 1e-16 relative) picked by the
+ * quadrant k. sin r takes the sign of r, so that sin(-0) is -0. Lanes
+ * beyond TRIG_LIMIT are passed through untouched for the caller to fix.
+ * Declared inline, as the loops of vecSin and vecCos only vectorize with
+ * it inlined.
+ * */
+static inline double sinLane(double x, uint64_t quadrant){
+	double kd, r, z, s, c, y;
+	uint64_t q, mask;
+
+	kd = x * TWOBYPI + SHIFT;
+	q = asBits(kd) + quadrant;
+	kd -= SHIFT;
+	r = ((x - kd * PIO2_1) - kd * PIO2_2) - kd * PIO2_3;
+	z = r * r;
+	s = -1.0/355687428096000.0;
+	s = 1.0/1307674368000.0 + z * s;
+	s = -1.0/6227020800.0 + z * s;
+	s = 1.0/39916800.0 + z * s;
+	s = -1.0/362880.0 + z * s;
+	s = 1.0/5040.0 + z * s;
+	s = -1.0/120.0 + z * s;
+	s = 1.0/6.0 + z * s;
+	s = copysign(r - r * z * s, r);
+	c = -1.0/6402373705728000.0;
+	c = 1.0/20922789888000.0 + z * c;
+	c = -1.0/87178291200.0 + z * c;
+	c = 1.0/479001600.0 + z * c;
+	c = -1.0/3628800.0 + z * c;
+	c = 1.0/40320.0 + z * c;
+	c = -1.0/720.0 + z * c;
+	c = 1.0/24.0 + z * c;
+	c = 1.0 - 0.5 * z + z * z * c;
+	/* select and negate with bit masks, which every target vectorizes */
+	mask = 0 - (q & 1);
+	y = asDouble(((asBits(c) & mask) | (asBits(s) & ~mask)) ^ ((q & 2) << 62));
+	return (fabs(x) <= TRIG_LIMIT) ? y : x;
+}
+
+VECMATH_CLONES
+void vecExp(const double* x, double* y, int n){
+	int i;
+	for (i = 0; i < n; i++)
+		y[i] = expLane(x[i]);
+}
+
+VECMATH_CLONES
+void vecLog(const double* x, double* y, int n){
+	int i;
+	for (i = 0; i < n; i++)
+		y[i] = logLane(x[i]);
+}
+
+/* Description: Out of range lanes keep their argument in y, so the fix
+ * up pass finds the argument in x even when x and y are the same array.
+ * */
+VECMATH_CLONES
+void vecSin(const double* x, double* y, int n){
+	int i;
+	for (i = 0; i < n; i++)
+		y[i] = sinLane(x[i], 0);
+	for (i = 0; i < n; i++)
+		if (!(fabs(x[i]) <= TRIG_LIMIT))
+			y[i] = sin(x[i]);
+}
+
+VECMATH_CLONES
+void vecCos(const double* x, double* y, int n){
+	int i;
+	for (i = 0; i < n; i++)
+		y[i] = sinLane(x[i], 1);
+	for (i = 0; i < n; i++)
+		if (!(fabs(x[i]) <= TRIG_LIMIT))
+			y[i] = cos(x[i]);
+}
+
+VECMATH_CLONES
+void vecPow(const double* x, const double* y, double* z, int n){
+	int i;
+	for (i = 0; i < n; i++)
+		z[i] = expLane(y[i] * logLane(x[i]));
+	for (i = 0; i < n; i++)
+		if (!(x[i] > 0.0 && x[i] <= DBL_MAX && fabs(y[i]) <= DBL_MAX))
+			z[i] = pow(x[i], y[i]);
+}
+
+/* Description: Reports which of the cloned kernels the loader picked.
+ * */
+const char* vecmathTarget(){
+#if defined(__GNUC__) && defined(__x86_64__) && defined(__linux__)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f"))
+		return "avx512f";
+	if (__builtin_cpu_supports("avx2"))
+		return "avx2";
+	return "sse2";
+#else
+	return "portable";
+#endif
+}
